@@ -0,0 +1,213 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#include "bmconfig.h"
+#include "bmharness.h"
+#include "hugemem.h"
+
+/// Thread-private scratch space (the locations a transaction picked, and
+/// what it read from them) is touched through these, so that it is not
+/// logged as part of the transaction's read and write sets.  Each attempt
+/// rewrites it from scratch, so there is nothing to roll back.
+__attribute__((transaction_pure))
+static void scratch_put(uint32_t* buf, uint32_t i, uint32_t v) { buf[i] = v; }
+
+__attribute__((transaction_pure))
+static uint32_t scratch_get(const uint32_t* buf, uint32_t i) { return buf[i]; }
+
+/// An array of -m zero-initialized counters, 'stride' bytes apart, for
+/// kernels whose read and write set sizes are set by -O
+class Array
+{
+  public:
+
+    /// the kernels
+    enum Kernel {
+        MCAS,           // increment -O random cells
+        READ_N_WRITE_1, // sum -O random cells into the last one
+        READ_WRITE_N    // read -O random cells, then write each one + 1
+    };
+
+    Kernel    kernel;
+    uint32_t  cells;
+    uint32_t  stride;
+    uint32_t  step;         /// stride, in words
+    uint32_t* words;
+
+    /// per-thread scratch, -O entries each
+    std::vector<uint32_t*> locs;
+    std::vector<uint32_t*> snapshots;
+
+    Array(Kernel k, uint32_t _cells, uint32_t _stride, uint32_t threads)
+        : kernel(k), cells(_cells), stride(_stride),
+          step(_stride / sizeof(uint32_t)),
+          locs(threads, NULL), snapshots(threads, NULL)
+    {
+        HugeMode got;
+        words = (uint32_t*)huge_alloc((size_t)cells * stride, false, got);
+        if (words == NULL) {
+            std::cerr << "Could not allocate the array\n";
+            exit(1);
+        }
+        for (size_t i = 0; i < (size_t)cells * step; ++i)
+            words[i] = 0;
+    }
+
+    void thread_init(int id) {
+        locs[id] = new uint32_t[Config::CFG.ops];
+        snapshots[id] = new uint32_t[Config::CFG.ops];
+    }
+
+    /// the cells the kernels read and write
+    __attribute__((transaction_safe))
+    uint32_t& cell(uint32_t i) { return words[i * step]; }
+
+    /// the IntSet methods read or increment one cell; the benchmark itself
+    /// uses array_op
+    __attribute__((transaction_safe))
+    bool lookup(int val) { return cell(val % cells) == 0; }
+
+    __attribute__((transaction_safe))
+    bool insert(int val) { return ++cell(val % cells) == 0; }
+
+    __attribute__((transaction_safe))
+    bool remove(int val) { return ++cell(val % cells) == 0; }
+
+    /// every MCAS transaction added exactly -O to the total; the other
+    /// kernels' totals can't be predicted
+    bool isSane() {
+        if (kernel != MCAS)
+            return true;
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < cells; ++i)
+            sum += cell(i);
+        return sum == (uint64_t)Config::CFG.txcount * Config::CFG.ops;
+    }
+
+    /// reads and writes of the array per transaction
+    uint32_t reads()  const { return Config::CFG.ops; }
+    uint32_t writes() const {
+        return (kernel == READ_N_WRITE_1) ? 1 : Config::CFG.ops;
+    }
+};
+
+/// One transaction of the selected kernel.  Locations are drawn inside the
+/// transaction from a local copy of the seed, which stays in registers.
+static bool array_op(Array* a, uint32_t id, uint32_t* seed)
+{
+    uint32_t ops = Config::CFG.ops;
+    uint32_t start = *seed, next;
+    uint32_t* locs = a->locs[id];
+    uint32_t* snapshot = a->snapshots[id];
+
+    switch (a->kernel) {
+      case Array::MCAS:
+        __transaction_atomic {
+            uint32_t s = start;
+            for (uint32_t i = 0; i < ops; ++i) {
+                uint32_t loc = rand_r_32(&s) % a->cells;
+                a->cell(loc) = 1 + a->cell(loc);
+            }
+            next = s;
+        }
+        break;
+      case Array::READ_N_WRITE_1:
+        __transaction_atomic {
+            uint32_t s = start, sum = 0, loc = 0;
+            for (uint32_t i = 0; i < ops; ++i) {
+                loc = rand_r_32(&s) % a->cells;
+                sum += a->cell(loc);
+            }
+            a->cell(loc) = sum;
+            next = s;
+        }
+        break;
+      default:
+        __transaction_atomic {
+            uint32_t s = start;
+            for (uint32_t i = 0; i < ops; ++i) {
+                uint32_t loc = rand_r_32(&s) % a->cells;
+                scratch_put(locs, i, loc);
+                scratch_put(snapshot, i, a->cell(loc));
+            }
+            for (uint32_t i = 0; i < ops; ++i)
+                a->cell(scratch_get(locs, i)) = 1 + scratch_get(snapshot, i);
+            next = s;
+        }
+    }
+    *seed = next;
+    return true;
+}
+
+/// This is the array we will manipulate in this experiment
+benchmark<Array>* SET;
+Array* ARRAY;
+
+/// This static, declared in bmconfig, needs to be defined
+Config Config::CFG;
+
+/// Names are Kernel[-stride], where Kernel is MCAS, ReadNWrite1, or
+/// ReadWriteN, and stride is the bytes between cells (default 4)
+void reparse_args()
+{
+    if (Config::CFG.bmname == "") Config::CFG.bmname = "MCAS";
+
+    std::string name = Config::CFG.bmname;
+    size_t dash = name.find('-');
+    std::string k = name.substr(0, dash);
+    uint32_t stride = (dash == std::string::npos)
+        ? 4 : atoi(name.c_str() + dash + 1);
+
+    Array::Kernel kernel;
+    if      (k == "MCAS")        kernel = Array::MCAS;
+    else if (k == "ReadNWrite1") kernel = Array::READ_N_WRITE_1;
+    else if (k == "ReadWriteN")  kernel = Array::READ_WRITE_N;
+    else {
+        std::cerr << "Unknown kernel " << k << "\n";
+        exit(1);
+    }
+    if (stride < 4 || stride % 4) {
+        std::cerr << "Array stride must be a multiple of 4 bytes\n";
+        exit(1);
+    }
+
+    ARRAY = new Array(kernel, Config::CFG.elements, stride,
+                      Config::CFG.threads);
+    SET = new benchmark<Array>(ARRAY);
+    SET->set_op(array_op);
+}
+
+/// We just call to SET functions in main
+int main(int argc, char** argv) {
+    // parse command line
+    Config::CFG.parseargs(argc, argv, "ArrayBench");
+    reparse_args();
+
+    // run the tests
+    SET->launch_test();
+
+    // throughput against read and write set size
+    double secs = Config::CFG.time / 1e9;
+    uint64_t txns = Config::CFG.txcount;
+    std::cout << "array, cells=" << ARRAY->cells
+              << ", stride=" << ARRAY->stride
+              << ", reads/tx=" << ARRAY->reads()
+              << ", writes/tx=" << ARRAY->writes()
+              << ", locations/sec="
+              << (uint64_t)(txns * (double)(ARRAY->reads() + ARRAY->writes())
+                            / secs)
+              << ", ns/location="
+              << (txns ? secs * 1e9 / txns / (ARRAY->reads() + ARRAY->writes())
+                       : 0)
+              << std::endl;
+
+    // print results
+    Config::CFG.dump_csv();
+}
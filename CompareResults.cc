@@ -0,0 +1,216 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#include <unistd.h>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "results.h"
+
+/**
+ * Compare two results stores (see results.h), e.g. from before and after a
+ * compiler or libitm upgrade.  Records are grouped by configuration; each
+ * configuration found in both stores is compared on one field (throughput
+ * by default, where higher is better) with Welch's t-test over its trials.
+ * The exit status is 1 if any configuration got significantly worse by at
+ * least the threshold, so that this can gate an upgrade.
+ */
+
+/// the trials of one configuration in one store
+struct Trials
+{
+    std::vector<double> v;
+
+    double mean() const {
+        double s = 0;
+        for (double x : v)
+            s += x;
+        return s / v.size();
+    }
+
+    double var() const {
+        double m = mean(), s = 0;
+        for (double x : v)
+            s += (x - m) * (x - m);
+        return s / (v.size() - 1);
+    }
+};
+
+typedef std::map<std::string, Trials> Store;
+
+/// read the records of a store, keeping field f of each
+static bool load(const char* path, const std::string& f, Store& out)
+{
+    std::ifstream in(path);
+    if (!in)
+        return false;
+    std::string line;
+    ResultRecord r;
+    while (std::getline(in, line))
+        if (r.parse(line) && r.fields.count(f))
+            out[r.key()].v.push_back(r.num(f));
+    return true;
+}
+
+/// continued fraction for the incomplete beta function (Numerical Recipes)
+static double betacf(double a, double b, double x)
+{
+    const double TINY = 1e-30;
+    double c = 1, d = 1 - (a + b) * x / (a + 1);
+    d = 1 / (std::fabs(d) < TINY ? TINY : d);
+    double h = d;
+    for (int m = 1; m <= 300; ++m) {
+        for (int odd = 0; odd < 2; ++odd) {
+            double aa = odd
+                ? -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1))
+                : m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m));
+            d = 1 + aa * d;
+            d = 1 / (std::fabs(d) < TINY ? TINY : d);
+            c = 1 + aa / c;
+            if (std::fabs(c) < TINY)
+                c = TINY;
+            h *= d * c;
+            if (odd && std::fabs(d * c - 1) < 1e-12)
+                return h;
+        }
+    }
+    return h;
+}
+
+/// the regularized incomplete beta function I_x(a, b)
+static double betai(double a, double b, double x)
+{
+    if (x <= 0 || x >= 1)
+        return x <= 0 ? 0 : 1;
+    double bt = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b)
+                         + a * std::log(x) + b * std::log(1 - x));
+    if (x < (a + 1) / (a + b + 2))
+        return bt * betacf(a, b, x) / a;
+    return 1 - bt * betacf(b, a, 1 - x) / b;
+}
+
+/// the t with P(|T| < t) = 1 - alpha, for Student's t with df degrees of
+/// freedom, by bisection
+static double t_crit(double df, double alpha)
+{
+    double lo = 0, hi = 1e4;
+    for (int i = 0; i < 200; ++i) {
+        double t = (lo + hi) / 2;
+        // two-sided tail probability of t
+        double tail = betai(df / 2, 0.5, df / (df + t * t));
+        if (tail > alpha)
+            lo = t;
+        else
+            hi = t;
+    }
+    return (lo + hi) / 2;
+}
+
+static void usage()
+{
+    std::cerr << "Usage: CompareResults [flags] <base store> <new store>\n"
+              << "    -f: field to compare, higher is better"
+              << " (default throughput)\n"
+              << "    -a: significance level (default 0.05)\n"
+              << "    -t: smallest change in % that counts as a regression"
+              << " (default 1)\n"
+              << "    -h: print help (this message)\n\n"
+              << "Exits with 1 if any configuration regressed, 2 on errors\n";
+}
+
+int main(int argc, char** argv)
+{
+    std::string field = "throughput";
+    double alpha = 0.05, threshold = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:a:t:h")) != -1) {
+        switch (opt) {
+          case 'f': field     = optarg; break;
+          case 'a': alpha     = atof(optarg); break;
+          case 't': threshold = atof(optarg); break;
+          default:
+            usage();
+            return 2;
+        }
+    }
+    if (argc - optind != 2 || alpha <= 0 || alpha >= 1) {
+        usage();
+        return 2;
+    }
+
+    Store base, next;
+    for (int i = 0; i < 2; ++i) {
+        if (!load(argv[optind + i], field, i ? next : base)) {
+            std::cerr << "Could not read " << argv[optind + i] << "\n";
+            return 2;
+        }
+    }
+
+    int matched = 0, regressions = 0, improvements = 0, unmatched = 0;
+    for (auto& b : base) {
+        auto n = next.find(b.first);
+        if (n == next.end()) {
+            ++unmatched;
+            continue;
+        }
+        ++matched;
+        const Trials& x = b.second;
+        const Trials& y = n->second;
+        double mx = x.mean(), my = y.mean();
+        double change = mx ? 100 * (my - mx) / mx : 0;
+        std::cout << "compare, " << b.first << ", base=" << mx
+                  << " (n=" << x.v.size() << "), new=" << my
+                  << " (n=" << y.v.size() << "), change=" << change << "%";
+
+        // a CI needs two trials on each side
+        if (x.v.size() < 2 || y.v.size() < 2 || !mx) {
+            std::cout << ", verdict=too few trials" << std::endl;
+            continue;
+        }
+
+        // Welch's t interval for the difference of the means, relative to
+        // the base mean (whose own error this ignores)
+        double vx = x.var() / x.v.size(), vy = y.var() / y.v.size();
+        double se = std::sqrt(vx + vy);
+        double half = 0;
+        if (se > 0) {
+            double df = (vx + vy) * (vx + vy)
+                / (vx * vx / (x.v.size() - 1) + vy * vy / (y.v.size() - 1));
+            half = t_crit(df, alpha) * se;
+        }
+        double lo = 100 * (my - mx - half) / mx;
+        double hi = 100 * (my - mx + half) / mx;
+        std::cout << ", ci=[" << lo << "%, " << hi << "%], verdict=";
+        if (hi < 0 && -change >= threshold) {
+            std::cout << "REGRESSION";
+            ++regressions;
+        }
+        else if (lo > 0 && change >= threshold) {
+            std::cout << "improvement";
+            ++improvements;
+        }
+        else {
+            std::cout << "same";
+        }
+        std::cout << std::endl;
+    }
+    for (auto& n : next)
+        unmatched += !base.count(n.first);
+
+    std::cout << "summary, field=" << field << ", confidence="
+              << 100 * (1 - alpha) << "%, matched=" << matched
+              << ", regressions=" << regressions
+              << ", improvements=" << improvements
+              << ", unmatched=" << unmatched << std::endl;
+    return regressions ? 1 : 0;
+}
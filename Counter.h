@@ -14,6 +14,17 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <cstdint>
+#include <climits>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <iostream>
+#include <new>
+#include <vector>
+
+extern thread_local int thread_id;
 
 class Counter
 {
@@ -53,3 +64,328 @@ class Counter
         return true;
     }
 };
+
+/// The rest of these are the counter suite: each treats lookup as a read of
+/// the counter and insert/remove as an increment, so -R sets the read ratio.
+/// isSane prints what a read returns now, the exact number of increments,
+/// and the difference (how stale a read can be).
+
+/// The counters pad to cache lines, but in C++11 new won't align them
+template<class C, class... Args>
+C* make_counter(Args... args)
+{
+    void* p;
+    if (posix_memalign(&p, 64, sizeof(C)) != 0) {
+        std::cerr << "Could not allocate the counter\n";
+        exit(1);
+    }
+    return new (p) C(args...);
+}
+
+/// the most threads a per-thread counter supports
+static const int COUNTER_MAX_THREADS = 256;
+
+/// an int on its own cache line
+struct PaddedInt
+{
+    int  val;
+    char padding[64 - sizeof(int)];
+} __attribute__((aligned(64)));
+
+/// print a counter's staleness, for isSane
+inline void counter_report(const char* name, long value, long exact)
+{
+    printf("%s value = %ld, exact = %ld, stale = %ld\n",
+           name, value, exact, exact - value);
+}
+
+/// One padded counter, incremented with a transaction.  Unlike Counter,
+/// reads don't write.
+class TMCounter
+{
+    PaddedInt counter;
+
+  public:
+
+    TMCounter() { counter.val = 0; }
+
+    __attribute__((transaction_safe))
+    bool lookup(int) const { return counter.val == 0; }
+
+    __attribute__((transaction_safe))
+    bool insert(int) { return ++counter.val == 0; }
+
+    __attribute__((transaction_safe))
+    bool remove(int) { return ++counter.val == 0; }
+
+    bool isSane() {
+        counter_report("TMCounter", counter.val, counter.val);
+        return true;
+    }
+};
+
+/// A padded stripe per thread: increments never conflict, but a read has
+/// to sum (and so conflicts with) every stripe
+class StripedCounter
+{
+    PaddedInt stripes[COUNTER_MAX_THREADS];
+    int       nstripes;
+
+    __attribute__((transaction_safe))
+    long sum() const {
+        long s = 0;
+        for (int i = 0; i < nstripes; ++i)
+            s += stripes[i].val;
+        return s;
+    }
+
+  public:
+
+    // a stripe per thread_id
+    static const int max_threads = COUNTER_MAX_THREADS;
+
+    StripedCounter(int threads) : nstripes(threads) {
+        for (int i = 0; i < COUNTER_MAX_THREADS; ++i)
+            stripes[i].val = 0;
+    }
+
+    __attribute__((transaction_safe))
+    bool lookup(int) const { return sum() == 0; }
+
+    __attribute__((transaction_safe))
+    bool insert(int) { return ++stripes[thread_id].val == 0; }
+
+    __attribute__((transaction_safe))
+    bool remove(int) { return ++stripes[thread_id].val == 0; }
+
+    bool isSane() {
+        counter_report("StripedCounter", sum(), sum());
+        return true;
+    }
+};
+
+/// A sloppy counter: each thread counts locally, and only adds its count to
+/// the global counter every 'threshold' increments.  Reads just see the
+/// global counter, so they can be behind by threads * (threshold - 1).
+class SloppyCounter
+{
+    PaddedInt global;
+    PaddedInt local[COUNTER_MAX_THREADS];
+    int       threshold;
+
+    __attribute__((transaction_safe))
+    bool increment() {
+        if (++local[thread_id].val >= threshold) {
+            global.val += local[thread_id].val;
+            local[thread_id].val = 0;
+        }
+        return global.val == 0;
+    }
+
+  public:
+
+    // a local count per thread_id
+    static const int max_threads = COUNTER_MAX_THREADS;
+
+    SloppyCounter(int _threshold) : threshold(_threshold) {
+        global.val = 0;
+        for (int i = 0; i < COUNTER_MAX_THREADS; ++i)
+            local[i].val = 0;
+    }
+
+    __attribute__((transaction_safe))
+    bool lookup(int) const { return global.val == 0; }
+
+    __attribute__((transaction_safe))
+    bool insert(int) { return increment(); }
+
+    __attribute__((transaction_safe))
+    bool remove(int) { return increment(); }
+
+    bool isSane() {
+        long exact = global.val;
+        for (int i = 0; i < COUNTER_MAX_THREADS; ++i)
+            exact += local[i].val;
+        counter_report("SloppyCounter", global.val, exact);
+        return true;
+    }
+
+    // the flush threshold in a name of the form Sloppy or Sloppy-<threshold>
+    // (default 64); says why and returns 0 if the name won't do
+    static int parse(const std::string& name)
+    {
+        char* end = NULL;
+        long threshold = (name.size() == 6) ? 64 : (name[6] == '-')
+                       ? strtol(name.c_str() + 7, &end, 10) : 0;
+        if (name.compare(0, 6, "Sloppy") != 0 || threshold < 1 ||
+            threshold > INT_MAX || (end && *end))
+        {
+            std::cerr << "Sloppy takes a positive threshold, as in"
+                      << " Sloppy-16\n";
+            return 0;
+        }
+        return threshold;
+    }
+};
+
+/// No TM at all: a std::atomic, incremented with fetch_add
+class AtomicCounter
+{
+    std::atomic<long> counter;
+    char              padding[64 - sizeof(long)];
+
+  public:
+
+    // the harness runs our operations directly, not in transactions
+    static const bool concurrent = true;
+
+    AtomicCounter() : counter(0) { }
+
+    bool lookup(int) const { return counter.load() == 0; }
+
+    bool insert(int) { return counter.fetch_add(1) == -1; }
+
+    bool remove(int) { return counter.fetch_add(1) == -1; }
+
+    bool isSane() {
+        counter_report("AtomicCounter", counter.load(), counter.load());
+        return true;
+    }
+};
+
+/// A software combining tree (Herlihy and Shavit, Ch. 12), without TM.
+/// Two threads share each leaf; a thread climbs until it finds a node no
+/// one else is at, collecting the increments of any thread it meets on the
+/// way, applies the combined increment at that node, and then hands each
+/// partner its share of the result on the way back down.
+class CombiningTreeCounter
+{
+    enum Status { IDLE, FIRST, SECOND, RESULT, ROOT };
+
+    /// a tree node: everything is protected by the node's mutex
+    struct Node
+    {
+        std::mutex              m;
+        std::condition_variable cv;
+        bool                    locked;
+        Status                  status;
+        long                    first_value;
+        long                    second_value;
+        long                    result;
+        Node*                   parent;
+
+        Node() : locked(false), status(IDLE), first_value(0),
+                 second_value(0), result(0), parent(NULL) { }
+
+        /// true if the caller should keep climbing
+        bool precombine() {
+            std::unique_lock<std::mutex> l(m);
+            cv.wait(l, [this] { return !locked; });
+            switch (status) {
+              case IDLE:  status = FIRST; return true;
+              case FIRST: locked = true; status = SECOND; return false;
+              default:    return false;
+            }
+        }
+
+        /// add in a partner's value (if any) on the way up
+        long combine(long combined) {
+            std::unique_lock<std::mutex> l(m);
+            cv.wait(l, [this] { return !locked; });
+            locked = true;
+            first_value = combined;
+            return (status == FIRST) ? first_value
+                                     : first_value + second_value;
+        }
+
+        /// at the stopping node: apply it at the root, or leave it for the
+        /// partner and wait for the result
+        long op(long combined) {
+            std::unique_lock<std::mutex> l(m);
+            if (status == ROOT) {
+                long prior = result;
+                result += combined;
+                return prior;
+            }
+            second_value = combined;
+            locked = false;
+            cv.notify_all();
+            cv.wait(l, [this] { return status == RESULT; });
+            locked = false;
+            cv.notify_all();
+            status = IDLE;
+            return result;
+        }
+
+        /// on the way down, hand the partner its result
+        void distribute(long prior) {
+            std::unique_lock<std::mutex> l(m);
+            if (status == FIRST) {
+                status = IDLE;
+                locked = false;
+            }
+            else {
+                result = prior + first_value;
+                status = RESULT;
+            }
+            cv.notify_all();
+        }
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Node*> leaves;
+
+    /// one increment, for thread id
+    long increment(int id) {
+        Node* leaf = leaves[id / 2];
+        Node* node = leaf;
+        while (node->precombine())
+            node = node->parent;
+        Node* stop = node;
+
+        Node* path[64];
+        int depth = 0;
+        long combined = 1;
+        for (node = leaf; node != stop; node = node->parent) {
+            combined = node->combine(combined);
+            path[depth++] = node;
+        }
+        long prior = stop->op(combined);
+        while (depth > 0)
+            path[--depth]->distribute(prior);
+        return prior;
+    }
+
+  public:
+
+    // the harness runs our operations directly, not in transactions
+    static const bool concurrent = true;
+
+    /// the tree is sized for a power of two >= threads
+    CombiningTreeCounter(int threads) {
+        int width = 2;
+        while (width < threads)
+            width *= 2;
+        nodes = std::vector<Node>(width - 1);
+        nodes[0].status = ROOT;
+        for (size_t i = 1; i < nodes.size(); ++i)
+            nodes[i].parent = &nodes[(i - 1) / 2];
+        for (int i = 0; i < width / 2; ++i)
+            leaves.push_back(&nodes[nodes.size() - i - 1]);
+    }
+
+    bool lookup(int) {
+        std::lock_guard<std::mutex> l(nodes[0].m);
+        return nodes[0].result == 0;
+    }
+
+    bool insert(int) { return increment(thread_id) == -1; }
+
+    bool remove(int) { return increment(thread_id) == -1; }
+
+    bool isSane() {
+        counter_report("CombiningTreeCounter", nodes[0].result,
+                       nodes[0].result);
+        return true;
+    }
+};
@@ -11,30 +11,65 @@
 #include "bmconfig.h"
 #include "bmharness.h"
 #include "Counter.h"
-
-/// This is the counter we'll manipulate in the experiment... we make it look
-/// like an IntSet so that we can reuse the benchmark template
-benchmark<Counter> SET;
+#include "NullSet.h"
 
 /// This static, declared in bmconfig, needs to be defined
 Config Config::CFG;
 
-/// No reparsing needed
+/// Counter is the default; the rest are the counter suite.  Sloppy takes an
+/// optional flush threshold, as in Sloppy-16 (default 64).  Null and EmptyTx
+/// are NullSets, which measure the harness without and with TM.
 void reparse_args() {
-    Config::CFG.bmname = "Counter";
+    if (Config::CFG.bmname == "")
+        Config::CFG.bmname = "Counter";
 }
 
-/// We just call to SET functions in main
-int main(int argc, char** argv) {
-    // parse command line
-    Config::CFG.parseargs(argc, argv, "CounterBench");
-    reparse_args();
+/// The counters are made to look like IntSets so that we can reuse the
+/// benchmark template
+template<class C>
+void run_counter(C* counter)
+{
+    benchmark<C> SET(counter);
 
     // warm up the data structure
     SET.warmup();
 
     // run the tests
     SET.launch_test();
+}
+
+/// We just call to SET functions in main
+int main(int argc, char** argv) {
+    // parse command line
+    Config::CFG.parseargs(argc, argv, "CounterBench");
+    reparse_args();
+
+    std::string name = Config::CFG.bmname;
+    int threads = Config::CFG.threads;
+    if (name == "TMCounter")
+        run_counter(make_counter<TMCounter>());
+    else if (name == "Striped")
+        run_counter(make_counter<StripedCounter>(threads));
+    else if (name.substr(0, 6) == "Sloppy") {
+        int threshold = SloppyCounter::parse(name);
+        if (!threshold)
+            exit(1);
+        run_counter(make_counter<SloppyCounter>(threshold));
+    }
+    else if (name == "Atomic")
+        run_counter(make_counter<AtomicCounter>());
+    else if (name == "CTree")
+        run_counter(new CombiningTreeCounter(threads));
+    else if (name == "Counter")
+        run_counter(new Counter());
+    else if (name == "Null")
+        run_counter(new NullSet<false>());
+    else if (name == "EmptyTx")
+        run_counter(new NullSet<true>());
+    else {
+        std::cerr << "Unknown counter " << name << "\n";
+        exit(1);
+    }
 
     // print results
     Config::CFG.dump_csv();
@@ -0,0 +1,176 @@
+#include <climits>
+#include "DList.h"
+
+// NB: m_val is both the key and the counter the increment workloads bump.
+//     The pattern and chunk increments don't bump every node, so afterwards
+//     keys can be out of order; check those runs with isLinked, and don't
+//     mix them with the IntSet methods.
+
+// constructor: head and tail have extreme values, point to each other
+DList::DList() : head(new Node(-1)), tail(new Node(INT_MAX))
+{
+    head->m_next = tail;
+    tail->m_prev = head;
+}
+
+// make sure the prev and next pointers agree, and that both traversals see
+// the same number of nodes
+bool DList::isLinked(void) const
+{
+    long forward = 0, backward = 0;
+    for (const Node* curr = head; curr != tail; curr = curr->m_next, forward++)
+        if ((curr->m_next == NULL) || (curr->m_next->m_prev != curr))
+            return false;
+    for (const Node* curr = tail; curr != head; curr = curr->m_prev, backward++)
+        if ((curr->m_prev == NULL) || (curr->m_prev->m_next != curr))
+            return false;
+    return forward == backward;
+}
+
+// simple sanity check: make sure the list is well linked, and all elements
+// are in sorted order
+bool DList::isSane(void) const
+{
+    if (!isLinked())
+        return false;
+    for (const Node* curr = head; curr != tail; curr = curr->m_next)
+        if (curr->m_val >= curr->m_next->m_val)
+            return false;
+    return true;
+}
+
+// insert method; find the right place in the list, add val so that it is in
+// sorted order; if val is already in the list, exit without inserting
+bool DList::insert(int val)
+{
+    // traverse the list to find the insertion point
+    Node* prev(head);
+    Node* curr(prev->m_next);
+    while (curr->m_val < val) {
+        prev = curr;
+        curr = curr->m_next;
+    }
+    if (curr->m_val == val)
+        return false;
+
+    // now insert a new node between prev and curr
+    Node* between = (Node*)malloc(sizeof(Node));
+    between->m_val = val;
+    between->m_prev = prev;
+    between->m_next = curr;
+    prev->m_next = between;
+    curr->m_prev = between;
+    return true;
+}
+
+// search for a value
+bool DList::lookup(int val) const
+{
+    const Node* curr(head->m_next);
+    while (curr->m_val < val)
+        curr = curr->m_next;
+    return curr->m_val == val;
+}
+
+// remove a node if its value == val
+bool DList::remove(int val)
+{
+    Node* curr(head->m_next);
+    while (curr->m_val < val)
+        curr = curr->m_next;
+    if ((curr == tail) || (curr->m_val != val))
+        return false;
+
+    // disconnect it and free it
+    curr->m_prev->m_next = curr->m_next;
+    curr->m_next->m_prev = curr->m_prev;
+    free(curr);
+    return true;
+}
+
+void DList::increment_forward()
+{
+    for (Node* curr = head->m_next; curr != tail; curr = curr->m_next)
+        curr->m_val++;
+}
+
+void DList::increment_backward()
+{
+    for (Node* curr = tail->m_prev; curr != head; curr = curr->m_prev)
+        curr->m_val++;
+}
+
+// increment every seqth element, starting with start, moving forward
+int DList::increment_forward_pattern(int start, int seq)
+{
+    int sum = 0;
+    // forward traversal to element # start
+    Node* curr(head->m_next);
+    for (int i = 0; (i < start) && (curr != tail); i++)
+        curr = curr->m_next;
+    // now do the remainder of the traversal, incrementing every seqth
+    // element and reading the rest
+    int ctr = seq;
+    while (curr != tail) {
+        if (ctr == seq) {
+            ctr = 0;
+            curr->m_val++;
+        }
+        else {
+            sum += curr->m_val;
+        }
+        ctr++;
+        curr = curr->m_next;
+    }
+    return sum;
+}
+
+// increment every seqth element, starting with start, moving backward
+int DList::increment_backward_pattern(int start, int seq)
+{
+    int sum = 0;
+    // backward traversal to element # start
+    Node* curr(tail->m_prev);
+    for (int i = 0; (i < start) && (curr != head); i++)
+        curr = curr->m_prev;
+    // now do the remainder of the traversal, incrementing every seqth
+    // element and reading the rest
+    int ctr = seq;
+    while (curr != head) {
+        if (ctr == seq) {
+            ctr = 0;
+            curr->m_val++;
+        }
+        else {
+            sum += curr->m_val;
+        }
+        ctr++;
+        curr = curr->m_prev;
+    }
+    return sum;
+}
+
+// read the whole list, then increment the chunk_size elements starting at
+// element chunk_num*chunk_size
+int DList::increment_chunk(int chunk_num, int chunk_size)
+{
+    int startpoint = chunk_num * chunk_size;
+    Node* chunk_start(NULL);
+    int ctr = 0;
+    int sum = 0;
+
+    // forward traversal to read everything and to find chunk_start
+    for (Node* curr = head->m_next; curr != tail; curr = curr->m_next) {
+        sum += curr->m_val;
+        if (ctr++ == startpoint)
+            chunk_start = curr;
+    }
+
+    // increment /chunk_size/ elements, stopping at the tail
+    Node* wr(chunk_start);
+    for (int i = 0; (wr != NULL) && (wr != tail) && (i < chunk_size); i++) {
+        wr->m_val++;
+        wr = wr->m_next;
+    }
+    return sum;
+}
@@ -0,0 +1,83 @@
+// -*-c++-*-
+
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+
+// Doubly-linked list, sorted, with head and tail sentinels.  Besides the
+// IntSet methods it has whole-list increment workloads; run from both ends
+// at once, these create the long write-write conflicts that make TMs
+// livelock or collapse.
+class DList
+{
+    // Node in a DList
+    struct Node
+    {
+        int   m_val;
+        Node* m_prev;
+        Node* m_next;
+
+        // basic constructor
+        Node(int val) : m_val(val), m_prev(), m_next() { }
+    };
+
+  public:
+
+    // the dlist keeps head and tail pointers, for bidirectional traversal
+    Node* head;
+    Node* tail;
+
+    DList();
+
+    // insert a node if it doesn't already exist
+    __attribute__((transaction_safe))
+    bool insert(int val);
+
+    // true iff val is in the data structure
+    __attribute__((transaction_safe))
+    bool lookup(int val) const;
+
+    // remove a node if its value = val
+    __attribute__((transaction_safe))
+    bool remove(int val);
+
+    // make sure the list is in sorted order, and well linked
+    bool isSane() const;
+
+    // make sure the prev and next pointers are consistent
+    bool isLinked() const;
+
+    // increment all elements, moving forward
+    __attribute__((transaction_safe))
+    void increment_forward();
+
+    // increment all elements, moving in reverse
+    __attribute__((transaction_safe))
+    void increment_backward();
+
+    // increment every seqth element, starting with start, moving forward;
+    // returns the sum of the other elements it passes
+    __attribute__((transaction_safe))
+    int increment_forward_pattern(int start, int seq);
+
+    // increment every seqth element, starting with start, moving backward;
+    // returns the sum of the other elements it passes
+    __attribute__((transaction_safe))
+    int increment_backward_pattern(int start, int seq);
+
+    // read the whole list, then increment every element in the chunk
+    // starting at chunk_num*chunk_size; returns the sum of what it read
+    __attribute__((transaction_safe))
+    int increment_chunk(int chunk_num, int chunk_size);
+};
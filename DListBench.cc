@@ -0,0 +1,41 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#include "bmconfig.h"
+#include "bmharness.h"
+#include "DList.h"
+
+/// This is the doubly-linked list we will manipulate in this experiment
+benchmark<DList> SET;
+
+/// This static, declared in bmconfig, needs to be defined
+Config Config::CFG;
+
+/// No special names
+void reparse_args()
+{
+    if (Config::CFG.bmname == "") Config::CFG.bmname = "DList";
+}
+
+/// We just call to SET functions in main
+int main(int argc, char** argv) {
+    // parse command line
+    Config::CFG.parseargs(argc, argv, "DListBench");
+    reparse_args();
+
+    // warm up the data structure
+    SET.warmup();
+
+    // run the tests
+    SET.launch_test();
+
+    // print results
+    Config::CFG.dump_csv();
+}
@@ -10,6 +10,15 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "alt-license/rand_r_32.h"
+#include "hugemem.h"
+
 extern thread_local int thread_id;
 
 // this is a benchmark for evaluating the overhead that TM induces for a
@@ -18,56 +27,151 @@ extern thread_local int thread_id;
 // locations that a transaction will touch, and the percentage of those
 // locations that are to be written.  We don't actually care about the values
 // read or written, since it's a microbenchmark.
+//
+// Entries are 'stride' bytes apart: 4 packs them, 64 gives each its own
+// line, and 128 also defeats the adjacent-line prefetcher.  Each thread
+// allocates (and so first-touches) its own buffer, optionally on huge
+// pages.  In the false-sharing layout there is one buffer, and the threads'
+// entries are interleaved in it, so that with a small stride threads share
+// lines without ever touching the same word.
 struct Disjoint
   {
       // const for keeping things from being 'too regular'
       static const unsigned DJBUFFER_SIZE = 1009;
       static const unsigned BUFFER_COUNT = 256;
 
-      // each transaction will work on special buffers, where entries in the
-      // buffer are pretty far apart
-      struct PaddedBufferEntry
-      {
-          uint32_t value;
-          char padding[64-sizeof(uint32_t)];
-          PaddedBufferEntry() : value(0), padding() { }
+      // where each thread's reads and writes go
+      enum Layout {
+          PRIVATE,        // DrDw: private reads and writes
+          SHARED_READ,    // SrDw: reads from a public buffer
+          FALSE_SHARING   // FsDw: private entries, interleaved in shared lines
       };
 
-      // array of padded entries
-      struct PaddedBuffer
-      {
-          PaddedBufferEntry buffer[DJBUFFER_SIZE];
-          PaddedBuffer() : buffer() { }
-      };
-
-      // private buffers for upto BUFFER_COUNT transactions
-      PaddedBuffer privateBuffers[BUFFER_COUNT];
+      // each thread's buffer (or, for FALSE_SHARING, its first entry)
+      uint32_t* privateBuffers[BUFFER_COUNT];
 
-      // public buffer (in case we need it)
-      PaddedBuffer publicBuffer;
+      // public buffer (in case we need it), or the interleaved buffer
+      uint32_t* publicBuffer;
 
       unsigned reads_per_ten;
       unsigned writes_per_ten;
       unsigned locations_per_transaction;
-      bool use_shared_read_buffer;
+      Layout   layout;
+      bool     use_shared_read_buffer;
+      bool     huge;
+
+      // bytes between entries, and between one thread's consecutive
+      // entries in words
+      unsigned stride;
+      unsigned step;
 
-      // constructor just sets up the execution parameters
+      // bytes in each thread's buffer, or in the public one
+      size_t   buffer_bytes;
+      size_t   public_bytes;
+
+      // the worst backing any buffer got, for reporting
+      std::atomic<int> huge_got;
+
+      // constructor just sets up the execution parameters; the buffers are
+      // made by each thread, in thread_init
       // R : reads_per_10
       // W : writes_per_10
       // L : locations_per_transaction
-      // S : use_shared_read_buffer
-      Disjoint(unsigned R, unsigned W, unsigned L, bool S)
-          : privateBuffers(), publicBuffer(),
+      // Y : layout
+      // B : stride (bytes between entries)
+      // H : use huge pages
+      // T : number of threads
+      Disjoint(unsigned R, unsigned W, unsigned L, Layout Y, unsigned B,
+               bool H, unsigned T)
+          : privateBuffers(), publicBuffer(NULL),
             reads_per_ten(R), writes_per_ten(W),
-            locations_per_transaction(L),
-            use_shared_read_buffer(S)
+            locations_per_transaction(L), layout(Y),
+            use_shared_read_buffer(Y == SHARED_READ), huge(H),
+            stride(B), step(B / sizeof(uint32_t)), buffer_bytes(DJBUFFER_SIZE * B),
+            public_bytes(0), huge_got(HUGE_TLB)
+      {
+          if (layout == FALSE_SHARING) {
+              step *= T;
+              public_bytes = buffer_bytes * T;
+          }
+          else if (layout == SHARED_READ) {
+              public_bytes = buffer_bytes;
+          }
+          if (public_bytes) {
+              publicBuffer = make_buffer(public_bytes, W);
+              if (layout == FALSE_SHARING)
+                  for (uint32_t i = 0; i < T; ++i)
+                      privateBuffers[i] = publicBuffer + i * (B / 4);
+          }
+      }
+
+      // make one from a name of the form XxDw-L-R-W[-stride][-huge], where
+      // Xx is Dr (private), Sr (shared reads), or Fs (false sharing), and
+      // stride defaults to 64 bytes (4 for Fs); says why and returns NULL
+      // if the name or thread count won't do
+      static Disjoint* parse(const std::string& name, bool huge,
+                             unsigned threads)
       {
-          unsigned int s = W;
-          for (uint32_t i = 0; i < BUFFER_COUNT; ++i)
-              for (unsigned j = 0; j < DJBUFFER_SIZE; ++j)
-                  privateBuffers[i].buffer[j].value = rand_r_32(&s);
-          for (unsigned j = 0; j < DJBUFFER_SIZE; ++j)
-              publicBuffer.buffer[j].value = rand_r_32(&s);
+          std::vector<std::string> parts;
+          size_t pos = 0, next;
+          while ((next = name.find('-', pos)) != std::string::npos) {
+              parts.push_back(name.substr(pos, next - pos));
+              pos = next + 1;
+          }
+          parts.push_back(name.substr(pos));
+          if (parts.size() < 4) {
+              std::cerr << "Disjoint names are XxDw-L-R-W[-stride][-huge]\n";
+              return NULL;
+          }
+          int size = atoi(parts[1].c_str());
+          int read = atoi(parts[2].c_str());
+          int write = atoi(parts[3].c_str());
+
+          Layout layout = PRIVATE;
+          if (parts[0] == "SrDw")
+              layout = SHARED_READ;
+          else if (parts[0] == "FsDw")
+              layout = FALSE_SHARING;
+
+          unsigned stride = (layout == FALSE_SHARING) ? 4 : 64;
+          for (size_t i = 4; i < parts.size(); ++i) {
+              if (parts[i] == "huge")
+                  huge = true;
+              else
+                  stride = atoi(parts[i].c_str());
+          }
+          if (stride < 4 || stride % 4) {
+              std::cerr << "Disjoint stride must be a multiple of 4 bytes\n";
+              return NULL;
+          }
+          if (threads > BUFFER_COUNT) {
+              std::cerr << "At most " << BUFFER_COUNT << " threads\n";
+              return NULL;
+          }
+          return new Disjoint(read, write, size, layout, stride, huge, threads);
+      }
+
+      // allocate and fill a buffer, and note how it is backed
+      uint32_t* make_buffer(size_t bytes, unsigned seed) {
+          HugeMode got;
+          uint32_t* b = (uint32_t*)huge_alloc(bytes, huge, got);
+          if (b == NULL) {
+              std::cerr << "Could not allocate a Disjoint buffer\n";
+              exit(1);
+          }
+          int worst = huge_got.load();
+          while (got < worst && !huge_got.compare_exchange_weak(worst, got))
+              ;
+          for (size_t j = 0; j < bytes / sizeof(uint32_t); ++j)
+              b[j] = rand_r_32(&seed);
+          return b;
+      }
+
+      // each thread makes its own buffer, so it lands on the thread's node
+      void thread_init(int id) {
+          if (layout != FALSE_SHARING && privateBuffers[id] == NULL)
+              privateBuffers[id] = make_buffer(buffer_bytes,
+                                               writes_per_ten + id);
       }
 
     private:
@@ -78,12 +182,12 @@ struct Disjoint
       __attribute__((transaction_safe))
       bool ro_transaction(uint32_t id, uint32_t startpoint) {
           unsigned sum = 0;
-          unsigned index = startpoint;
-          PaddedBuffer& rBuffer =
+          unsigned index = startpoint % DJBUFFER_SIZE;
+          const uint32_t* rBuffer =
               use_shared_read_buffer ? publicBuffer : privateBuffers[id];
 
           for (unsigned i = 0; i < locations_per_transaction; i++) {
-              sum += rBuffer.buffer[index].value;
+              sum += rBuffer[index * step];
               // compute the next index
               index = (index + 1) % DJBUFFER_SIZE;
           }
@@ -96,10 +200,11 @@ struct Disjoint
       __attribute__((transaction_safe))
       bool r_rw_transaction(uint32_t id, uint32_t startpoint)
       {
-          PaddedBuffer& rBuffer =
+          const uint32_t* rBuffer =
               use_shared_read_buffer ? publicBuffer : privateBuffers[id];
-          PaddedBuffer& wBuffer = privateBuffers[id];
-          unsigned index = startpoint, writes = 0, reads = 0, buff = 0;
+          uint32_t* wBuffer = privateBuffers[id];
+          unsigned index = startpoint % DJBUFFER_SIZE;
+          unsigned writes = 0, reads = 0, buff = 0;
 
           for (unsigned i = 0; i < locations_per_transaction; i++) {
               // if we've done ten things, then reset the read and write
@@ -119,12 +224,12 @@ struct Disjoint
               // perform the selected action
               if (should_write) {
                   // increment the item (read and write it)
-                  unsigned oldval = (wBuffer.buffer[index].value);
-                  wBuffer.buffer[index].value =  (uint32_t)(oldval + 1);
+                  unsigned oldval = wBuffer[index * step];
+                  wBuffer[index * step] = (uint32_t)(oldval + 1);
                   writes++;
               }
               else {
-                  buff += rBuffer.buffer[index].value;
+                  buff += rBuffer[index * step];
                   reads++;
               }
 
@@ -5,23 +5,22 @@
 /// This is the tree we will manipulate in this experiment
 benchmark<Disjoint>* SET;
 
+/// and the Disjoint itself, so we can report its layout
+Disjoint* DJ;
+
 /// This static, declared in bmconfig, needs to be defined
 Config Config::CFG;
 
-/*** Initialize the disjoint buffers */
+/*** Initialize the disjoint buffers.  Names are as Disjoint::parse takes
+ *   them; -H implies -huge */
 void reparse_args() {
     if (Config::CFG.bmname == "") Config::CFG.bmname   = "DrDw-10-10-0";
 
-    std::string str = Config::CFG.bmname;
-    int pos1 = str.find_first_of('-', 0);
-    int pos2 = str.find_first_of('-', pos1+1);
-    int pos3 = str.find_first_of('-', pos2+1);
-    int pos4 = str.size();
-    int size = atoi(str.substr(pos1+1, pos2-pos1-1).c_str());
-    int read = atoi(str.substr(pos2+1, pos3-pos2-1).c_str());
-    int write = atoi(str.substr(pos3+1, pos4-pos3-1).c_str());
-    bool shared = (Config::CFG.bmname.substr(0, 4) == "SrDw");
-    SET = new benchmark<Disjoint>(new Disjoint(read, write, size, shared));
+    DJ = Disjoint::parse(Config::CFG.bmname, Config::CFG.hugepages,
+                         Config::CFG.threads);
+    if (!DJ)
+        exit(1);
+    SET = new benchmark<Disjoint>(DJ);
 }
 
 /// We just call to SET functions in main
@@ -33,7 +32,12 @@ int main(int argc, char** argv) {
     // run the tests
     SET->launch_test();
 
+    // how the buffers were laid out
+    std::cout << "disjoint, stride=" << DJ->stride
+              << ", bytes/buffer=" << DJ->buffer_bytes
+              << ", pages=" << huge_name((HugeMode)DJ->huge_got.load())
+              << std::endl;
+
     // print results
     Config::CFG.dump_csv();
 }
-
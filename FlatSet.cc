@@ -0,0 +1,115 @@
+#include <cstring>
+#include "FlatSet.h"
+
+// NB: keys are moved with explicit memmove/memcpy, which the TM pass turns
+//     into _ITM_memmove and friends (see UnrolledList.cc)
+
+// the capacity of a new FlatSet
+static const uint32_t INITIAL_CAP = 16;
+
+// constructor: an empty array, with all of its space free
+FlatSet::FlatSet(bool gap)
+    : m_keys((int*)malloc(INITIAL_CAP * sizeof(int))), m_count(0),
+      m_cap(INITIAL_CAP), m_gap(0), m_packed(!gap)
+{ }
+
+// skip over the gap
+uint32_t FlatSet::slot(uint32_t i) const
+{
+    return (i < m_gap) ? i : i + (m_cap - m_count);
+}
+
+// binary search, in logical positions
+uint32_t FlatSet::rank(int val) const
+{
+    uint32_t lo = 0, hi = m_count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (m_keys[slot(mid)] < val)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// moving the gap down shifts the keys in [pos, m_gap) up past it, and
+// moving it up shifts the keys after it down
+void FlatSet::move_gap(uint32_t pos)
+{
+    uint32_t len = m_cap - m_count;
+    if (pos < m_gap)
+        memmove(&m_keys[pos + len], &m_keys[pos],
+                (m_gap - pos) * sizeof(int));
+    else if (pos > m_gap)
+        memmove(&m_keys[m_gap], &m_keys[m_gap + len],
+                (pos - m_gap) * sizeof(int));
+    m_gap = pos;
+}
+
+// new array, with the keys packed at the front
+void FlatSet::grow()
+{
+    move_gap(m_count);
+    int* keys = (int*)malloc(2 * m_cap * sizeof(int));
+    memcpy(keys, m_keys, m_count * sizeof(int));
+    free(m_keys);
+    m_keys = keys;
+    m_cap *= 2;
+}
+
+// simple sanity check: the keys are in sorted order, and the gap is inside
+// the array
+bool FlatSet::isSane(void) const
+{
+    if ((m_count > m_cap) || (m_gap > m_count))
+        return false;
+    if (m_packed && (m_gap != m_count))
+        return false;
+    for (uint32_t i = 1; i < m_count; ++i)
+        if (m_keys[slot(i - 1)] >= m_keys[slot(i)])
+            return false;
+    return true;
+}
+
+// search function
+bool FlatSet::lookup(int val) const
+{
+    uint32_t r = rank(val);
+    return (r < m_count) && (m_keys[slot(r)] == val);
+}
+
+// insert method; open the gap at val's position, and put val at its start
+bool FlatSet::insert(int val)
+{
+    uint32_t r = rank(val);
+    if ((r < m_count) && (m_keys[slot(r)] == val))
+        return false;
+    if (m_count == m_cap)
+        grow();
+    // packed: the gap stays at the end, so just shift the larger keys up
+    if (m_packed)
+        memmove(&m_keys[r + 1], &m_keys[r], (m_count - r) * sizeof(int));
+    else
+        move_gap(r);
+    m_keys[r] = val;
+    m_count++;
+    m_gap = m_packed ? m_count : r + 1;
+    return true;
+}
+
+// remove val if present: move the gap to just after it, and let the gap
+// swallow it
+bool FlatSet::remove(int val)
+{
+    uint32_t r = rank(val);
+    if ((r == m_count) || (m_keys[slot(r)] != val))
+        return false;
+    if (m_packed)
+        memmove(&m_keys[r], &m_keys[r + 1], (m_count - r - 1) * sizeof(int));
+    else
+        move_gap(r + 1);
+    m_count--;
+    m_gap = m_packed ? m_count : r;
+    return true;
+}
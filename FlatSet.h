@@ -0,0 +1,70 @@
+// -*-c++-*-
+
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+
+// Sorted set as one contiguous array of keys: lookups are a binary search,
+// and updates shift keys over with memmove.  Optionally the free space is
+// kept as a gap wherever the last update happened, instead of at the end,
+// so an update only has to move the keys between the gap and its position.
+// Under TM every shifted key is a logged write, so this is the opposite
+// trade-off from RBTree: few, contiguous reads, but O(n) writes.
+class FlatSet
+{
+    // keys live in [0, m_gap) and [m_gap + (m_cap - m_count), m_cap)
+    int*     m_keys;
+    uint32_t m_count;
+    uint32_t m_cap;
+    uint32_t m_gap;
+
+    // leave the free space at the end after every update?
+    bool     m_packed;
+
+    // where the ith smallest key is stored
+    __attribute__((transaction_safe))
+    uint32_t slot(uint32_t i) const;
+
+    // number of keys less than val
+    __attribute__((transaction_safe))
+    uint32_t rank(int val) const;
+
+    // move the gap so that it starts at logical position pos
+    __attribute__((transaction_safe))
+    void move_gap(uint32_t pos);
+
+    // double the capacity, leaving the gap at the end
+    __attribute__((transaction_safe))
+    void grow();
+
+  public:
+
+    // gap: keep the free space where the last update was
+    FlatSet(bool gap = false);
+
+    // true iff val is in the data structure
+    __attribute__((transaction_safe))
+    bool lookup(int val) const;
+
+    // standard IntSet methods
+    __attribute__((transaction_safe))
+    bool insert(int val);
+
+    // remove val if it is present
+    __attribute__((transaction_safe))
+    bool remove(int val);
+
+    // make sure the keys are in sorted order
+    bool isSane() const;
+};
@@ -0,0 +1,235 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "bmconfig.h"
+#include "bmharness.h"
+#include "keydist.h"
+#include "Tree.h"
+#include "verify.h"
+
+/// One tree operation, drawn before the transaction starts
+struct ForestOp
+{
+    uint32_t tree;
+    int      key;
+    uint32_t act;
+};
+
+/// Each thread's scratch space and per-tree counters
+struct ForestThread
+{
+    std::vector<ForestOp> ops;
+    std::vector<uint64_t> attempts;     /// transaction attempts, per tree
+    std::vector<uint64_t> commits;      /// commits, per tree
+};
+
+/// the calling thread's ForestThread
+thread_local ForestThread* my_forest;
+
+/// Count an attempt on a tree.  This is pure, so aborts don't undo it, and
+/// attempts - commits is the number of aborted attempts that touched it.
+__attribute__((transaction_pure))
+static void note_attempt(uint32_t tree)
+{
+    my_forest->attempts[tree]++;
+}
+
+/// A forest of RBTrees (-S of them, each with keys in [0, -m)), where each
+/// transaction does -O operations on random trees.  Keys are drawn from one
+/// distribution over all (tree, key) pairs, range partitioned, so under a
+/// skewed distribution the low trees are the hot ones.
+class Forest
+{
+  public:
+    uint32_t keys;
+    uint32_t total_trees;
+    uint32_t trees_per_tx;
+    RBTree** trees;
+    KeyDist* dist;
+    std::vector<ForestThread*> local;
+    uint64_t build_time;
+
+    /// create all the trees, with each thread building and populating its
+    /// share of them
+    Forest(uint32_t _keys, uint32_t _trees, uint32_t per, KeyDist* _dist,
+           uint32_t threads)
+        : keys(_keys), total_trees(_trees), trees_per_tx(per),
+          trees(new RBTree*[_trees]), dist(_dist), local(threads, NULL)
+    {
+        uint64_t start = getElapsedTime();
+        std::vector<std::thread> builders;
+        for (uint32_t t = 0; t < threads; ++t)
+            builders.push_back(std::thread([this, t, threads] {
+                for (uint32_t i = t; i < total_trees; i += threads) {
+                    trees[i] = new RBTree();
+                    for (uint32_t w = 0; w < keys; w += 2)
+                        trees[i]->insert(w);
+                }
+            }));
+        for (std::thread& b : builders)
+            b.join();
+        build_time = getElapsedTime() - start;
+    }
+
+    /// per-thread counters, allocated by their thread
+    void thread_init(int id) {
+        ForestThread* t = new ForestThread();
+        t->ops.resize(trees_per_tx);
+        t->attempts.assign(total_trees, 0);
+        t->commits.assign(total_trees, 0);
+        local[id] = my_forest = t;
+    }
+
+    /// the IntSet methods treat val as a key in the first tree; the
+    /// benchmark itself uses forest_op
+    __attribute__((transaction_safe))
+    bool lookup(int val) const { return trees[0]->lookup(val); }
+
+    __attribute__((transaction_safe))
+    bool insert(int val) { return trees[0]->insert(val); }
+
+    __attribute__((transaction_safe))
+    bool remove(int val) { return trees[0]->remove(val); }
+
+    bool isSane() const {
+        for (uint32_t i = 0; i < total_trees; ++i)
+            if (!trees[i]->isSane())
+                return false;
+        return true;
+    }
+
+    /// the trees are the units of a parallel (or sampled) check
+    bool verify(uint32_t threads, uint32_t sample) const {
+        return verify_units(total_trees, threads, sample, [this](uint32_t i) {
+            return trees[i]->isSane();
+        });
+    }
+
+    /// report attempts and commits, overall and for the most-aborted trees
+    void report() const {
+        std::vector<uint64_t> attempts(total_trees, 0), commits(total_trees, 0);
+        for (const ForestThread* t : local) {
+            if (t == NULL)
+                continue;
+            for (uint32_t i = 0; i < total_trees; ++i) {
+                attempts[i] += t->attempts[i];
+                commits[i] += t->commits[i];
+            }
+        }
+        uint64_t a = 0, c = 0;
+        std::vector<uint32_t> order(total_trees);
+        for (uint32_t i = 0; i < total_trees; ++i) {
+            a += attempts[i];
+            c += commits[i];
+            order[i] = i;
+        }
+        std::cout << "forest, trees=" << total_trees
+                  << ", per_tx=" << trees_per_tx << ", keys=" << keys
+                  << ", dist=" << dist->name()
+                  << ", build_ms=" << build_time / 1000000
+                  << ", tree_attempts=" << a << ", tree_commits=" << c
+                  << ", aborts/commit=" << (c ? (double)(a - c) / c : 0)
+                  << std::endl;
+
+        // the trees that lost the most work to aborts
+        std::sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) {
+            return attempts[x] - commits[x] > attempts[y] - commits[y];
+        });
+        for (uint32_t i = 0; i < std::min(total_trees, 5u); ++i) {
+            uint32_t t = order[i];
+            std::cout << "forest tree " << t << ": attempts=" << attempts[t]
+                      << ", commits=" << commits[t]
+                      << ", aborts=" << attempts[t] - commits[t] << std::endl;
+        }
+    }
+};
+
+/// One transaction: draw the operations, run them, and count the commit
+/// against every tree it touched
+static bool forest_op(Forest* f, uint32_t id, uint32_t* seed)
+{
+    ForestThread* t = f->local[id];
+    ForestOp* ops = t->ops.data();
+    for (uint32_t i = 0; i < f->trees_per_tx; ++i) {
+        uint64_t k = f->dist->next(seed);
+        ops[i].tree = k / f->keys;
+        ops[i].key  = k % f->keys;
+        ops[i].act  = rand_r_32(seed) % 100;
+    }
+
+    bool ran = false;
+    __transaction_atomic {
+        if (Config::still_running()) {
+            for (uint32_t i = 0; i < f->trees_per_tx; ++i) {
+                RBTree* tree = f->trees[ops[i].tree];
+                note_attempt(ops[i].tree);
+                if (ops[i].act < Config::CFG.lookpct)
+                    tree->lookup(ops[i].key);
+                else if (ops[i].act < Config::CFG.inspct)
+                    tree->insert(ops[i].key);
+                else
+                    tree->remove(ops[i].key);
+            }
+            ran = true;
+        }
+    }
+    if (ran)
+        for (uint32_t i = 0; i < f->trees_per_tx; ++i)
+            t->commits[ops[i].tree]++;
+    return ran;
+}
+
+/// This is the forest we will manipulate in this experiment
+benchmark<Forest>* SET;
+Forest* FOREST;
+
+/// This static, declared in bmconfig, needs to be defined
+Config Config::CFG;
+
+/// Names are Forest[-dist], where dist is uniform (the default), zipf, or
+/// zipf<theta>.  The shape comes from -S (trees), -O (trees per
+/// transaction), and -m (keys per tree).
+void reparse_args()
+{
+    if (Config::CFG.bmname == "") Config::CFG.bmname = "Forest";
+
+    std::string name = Config::CFG.bmname;
+    std::string d = (name.size() > 7) ? name.substr(7) : "uniform";
+    uint64_t space = (uint64_t)Config::CFG.sets * Config::CFG.elements;
+    KeyDist* dist = KeyDist::parse(d, space);
+    if (name.compare(0, 6, "Forest") != 0 || dist == NULL) {
+        std::cerr << "Forest names are Forest[-uniform|-zipf|-zipf<theta>]\n";
+        exit(1);
+    }
+
+    FOREST = new Forest(Config::CFG.elements, Config::CFG.sets,
+                        Config::CFG.ops, dist, Config::CFG.threads);
+    SET = new benchmark<Forest>(FOREST);
+    SET->set_op(forest_op);
+}
+
+/// We just call to SET functions in main
+int main(int argc, char** argv) {
+    // parse command line
+    Config::CFG.parseargs(argc, argv, "ForestBench");
+    reparse_args();
+
+    // run the tests
+    SET->launch_test();
+
+    // per-tree conflicts
+    FOREST->report();
+
+    // print results
+    Config::CFG.dump_csv();
+}
@@ -0,0 +1,114 @@
+#include <climits>
+#include "HarrisList.h"
+
+// constructor just makes a sentinel for the data structure
+HarrisList::HarrisList() : sentinel(new_node(INT_MIN, 0)) { }
+
+// simple sanity check: make sure all elements of the list are in sorted
+// order, and that no deleted node is still linked in
+bool HarrisList::isSane(void) const
+{
+    const Node* prev(sentinel);
+    uintptr_t next = prev->m_next;
+    while (next != 0) {
+        const Node* curr = ptr(next);
+        if (marked(next) || (prev->m_val >= curr->m_val))
+            return false;
+        prev = curr;
+        next = curr->m_next;
+    }
+    return true;
+}
+
+// Michael's search: on return, curr is the first unmarked node with a value
+// >= val (or NULL), and *prev was the link to it
+bool HarrisList::find(int val, std::atomic<uintptr_t>*& prev, Node*& curr)
+{
+  retry:
+    prev = &sentinel->m_next;
+    curr = ptr(prev->load());
+    while (curr != NULL) {
+        uintptr_t next = curr->m_next.load();
+        // if prev changed (or its node was marked), start over
+        if (prev->load() != (uintptr_t)curr)
+            goto retry;
+        if (!marked(next)) {
+            if (curr->m_val >= val)
+                return curr->m_val == val;
+            prev = &curr->m_next;
+        }
+        else {
+            // curr is deleted; unlink it on its deleter's behalf
+            uintptr_t expected = (uintptr_t)curr;
+            if (!prev->compare_exchange_strong(expected, (uintptr_t)ptr(next)))
+                goto retry;
+            reclaimer.retire(curr, sizeof(Node));
+        }
+        curr = ptr(next);
+    }
+    return false;
+}
+
+// search function; never writes, never retries
+bool HarrisList::lookup(int val) const
+{
+    epoch_reclaimer& r = const_cast<epoch_reclaimer&>(reclaimer);
+    r.enter();
+    const Node* curr = ptr(sentinel->m_next.load());
+    while ((curr != NULL) && (curr->m_val < val))
+        curr = ptr(curr->m_next.load());
+    bool found = (curr != NULL) && (curr->m_val == val)
+              && !marked(curr->m_next.load());
+    r.exit();
+    return found;
+}
+
+// insert method; link a new node in front of the first node >= val, unless
+// val is already there
+bool HarrisList::insert(int val)
+{
+    reclaimer.enter();
+    Node* n = new_node(val, 0);
+    std::atomic<uintptr_t>* prev;
+    Node* curr;
+    while (true) {
+        if (find(val, prev, curr)) {
+            free(n);
+            reclaimer.exit();
+            return false;
+        }
+        n->m_next.store((uintptr_t)curr, std::memory_order_relaxed);
+        uintptr_t expected = (uintptr_t)curr;
+        if (prev->compare_exchange_strong(expected, (uintptr_t)n)) {
+            reclaimer.exit();
+            return true;
+        }
+    }
+}
+
+// remove a node if its value == val: mark it, then try to unlink it
+bool HarrisList::remove(int val)
+{
+    reclaimer.enter();
+    std::atomic<uintptr_t>* prev;
+    Node* curr;
+    while (true) {
+        if (!find(val, prev, curr)) {
+            reclaimer.exit();
+            return false;
+        }
+        uintptr_t next = curr->m_next.load();
+        if (marked(next))
+            continue;
+        if (!curr->m_next.compare_exchange_strong(next, next | 1))
+            continue;
+        // logically deleted; if the unlink fails, a find will finish it
+        uintptr_t expected = (uintptr_t)curr;
+        if (prev->compare_exchange_strong(expected, next))
+            reclaimer.retire(curr, sizeof(Node));
+        else
+            find(val, prev, curr);
+        reclaimer.exit();
+        return true;
+    }
+}
@@ -0,0 +1,75 @@
+// -*-c++-*-
+
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include "reclaim.h"
+
+// Lock-free sorted linked list (Harris, with Michael's changes so that nodes
+// can be reclaimed).  A node is deleted by first setting the low bit of its
+// next pointer, and then unlinking it; any traversal that runs into a marked
+// node helps unlink it.  This does not use TM at all: it is the non-TM
+// reference point for List.
+class HarrisList
+{
+    // Node in a HarrisList; the low bit of m_next is the deleted mark
+    struct Node
+    {
+        int                    m_val;
+        std::atomic<uintptr_t> m_next;
+
+        Node(int val, uintptr_t next) : m_val(val), m_next(next) { }
+    };
+
+    // nodes are malloc'd, since the reclaimer free()s them
+    static Node* new_node(int val, uintptr_t next) {
+        return new (malloc(sizeof(Node))) Node(val, next);
+    }
+
+    static bool  marked(uintptr_t p) { return p & 1; }
+    static Node* ptr(uintptr_t p)    { return (Node*)(p & ~(uintptr_t)1); }
+
+    Node* sentinel;
+
+    // unlinked nodes wait here until no one can be looking at them
+    epoch_reclaimer reclaimer;
+
+    // find the first node >= val, unlinking marked nodes along the way.
+    // On return, *prev is the link that pointed to curr.
+    bool find(int val, std::atomic<uintptr_t>*& prev, Node*& curr);
+
+  public:
+
+    // the harness runs our operations directly, not in transactions
+    static const bool concurrent = true;
+
+    // the reclaimer has a record per thread_id
+    static const int max_threads = RECLAIM_MAX_THREADS;
+
+    HarrisList();
+
+    // true iff val is in the data structure
+    bool lookup(int val) const;
+
+    // standard IntSet methods
+    bool insert(int val);
+
+    // remove a node if its value = val
+    bool remove(int val);
+
+    // make sure the list is in sorted order, with no marked nodes
+    bool isSane() const;
+};
@@ -0,0 +1,132 @@
+// -*-c++-*-
+
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#pragma once
+
+#include "List.h"
+#include "image.h"
+#include "verify.h"
+
+// the HashMap class is an array of N_BUCKETS ListMaps, hashed by key modulo
+// N_BUCKETS, so keys must convert to uint32_t.  HashTable is the IntSet.
+template<class K, class V>
+class HashMap
+{
+    static const int N_BUCKETS = 256;
+
+    /**
+     *  during a sanity check, we want to make sure that every element in a
+     *  bucket actually hashes to that bucket; we do it by passing this
+     *  method to the extendedSanityCheck for the bucket.
+     */
+    static bool verify_hash_function(uint32_t val, uint32_t bucket)
+    {
+        return ((val % N_BUCKETS) == bucket);
+    }
+
+    static uint32_t hash(const K& val) { return (uint32_t)val % N_BUCKETS; }
+
+  public:
+    /**
+     *  Each bucket is a sorted list of the keys that hash to it.
+     */
+    ListMap<K, V> bucket[N_BUCKETS];
+
+    __attribute__((transaction_safe))
+    bool insert(const K& val)
+    {
+        return bucket[hash(val)].insert(val);
+    }
+
+    __attribute__((transaction_safe))
+    bool lookup(const K& val) const
+    {
+        return bucket[hash(val)].lookup(val);
+    }
+
+    __attribute__((transaction_safe))
+    bool remove(const K& val)
+    {
+        return bucket[hash(val)].remove(val);
+    }
+
+    __attribute__((transaction_safe))
+    bool get(const K& val, V& data) const
+    {
+        return bucket[hash(val)].get(val, data);
+    }
+
+    __attribute__((transaction_safe))
+    bool insert_or_assign(const K& val, const V& data)
+    {
+        return bucket[hash(val)].insert_or_assign(val, data);
+    }
+
+    __attribute__((transaction_safe))
+    bool update(const K& val, const V& data)
+    {
+        return bucket[hash(val)].update(val, data);
+    }
+
+    bool isSane() const
+    {
+        for (int i = 0; i < N_BUCKETS; i++)
+            if (!bucket[i].extendedSanityCheck(verify_hash_function, i))
+                return false;
+        return true;
+    }
+
+    // the buckets are the units of a parallel (or sampled) check
+    bool verify(uint32_t threads, uint32_t sample) const
+    {
+        return verify_units(N_BUCKETS, threads, sample, [this](uint32_t i) {
+            return bucket[i].extendedSanityCheck(verify_hash_function, i);
+        });
+    }
+
+    // an image holds the buckets' lists back to back; see image.h
+    bool save_image(const char* path, uint64_t elements) const
+    {
+        image_writer w(path, "HashMap", ListMap<K, V>::image_node_size(),
+                       elements);
+        if (!w.ok())
+            return false;
+        uint64_t i = 0;
+        for (int b = 0; b < N_BUCKETS; ++b)
+            i = bucket[b].image_put(w, i);
+        return w.finish();
+    }
+
+    // check that the image has exactly N_BUCKETS lists before taking any
+    bool load_image(const char* path, uint64_t elements)
+    {
+        uint64_t n, i = 0;
+        uint32_t size = ListMap<K, V>::image_node_size();
+        char* base = image_map(path, "HashMap", size, elements, n);
+        if (!base)
+            return false;
+        bool ok = true;
+        for (int b = 0; b < N_BUCKETS && ok; ++b)
+            ok = (i = ListMap<K, V>::image_end(base, i, n)) != 0;
+        if (!ok || i != n) {
+            image_unmap(base, size, n);
+            return false;
+        }
+        i = 0;
+        for (int b = 0; b < N_BUCKETS; ++b)
+            i = bucket[b].image_take(base, i);
+        return true;
+    }
+};
+
+// the integer set that the benchmarks use
+typedef HashMap<int, NoValue> HashTable;
@@ -0,0 +1,62 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#include "bmconfig.h"
+#include "bmharness.h"
+#include "Hash.h"
+#include "payload.h"
+
+/// This static, declared in bmconfig, needs to be defined
+Config Config::CFG;
+
+/// A helper function to update the configuration based on some custom names
+void reparse_args()
+{
+    if (Config::CFG.bmname == "") Config::CFG.bmname = "Hash";
+}
+
+/// Build, warm up, and test a hash table of type H
+template<class H>
+void run_hash()
+{
+    // This is the hash table we will manipulate in this experiment
+    benchmark<H> SET;
+
+    // warm up the data structure
+    SET.warmup();
+
+    // run the tests
+    SET.launch_test();
+}
+
+/// With -V, the table is a map to values of that many bytes
+struct run_map
+{
+    template<class V>
+    void run() { run_hash<PayloadSet<HashMap<int, V>, V> >(); }
+};
+
+/// We just call to SET functions in main
+int main(int argc, char** argv) {
+    // parse command line
+    Config::CFG.parseargs(argc, argv, "HashBench");
+    reparse_args();
+
+    if (!Config::CFG.value_size)
+        run_hash<HashTable>();
+    else if (!with_payload(Config::CFG.value_size, run_map())) {
+        std::cerr << "Unsupported value size " << Config::CFG.value_size
+                  << "\n";
+        exit(1);
+    }
+
+    // print results
+    Config::CFG.dump_csv();
+}
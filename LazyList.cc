@@ -0,0 +1,106 @@
+#include <climits>
+#include "LazyList.h"
+
+// constructor makes the two sentinels
+LazyList::LazyList() : head(new_node(INT_MIN, new_node(INT_MAX, NULL))) { }
+
+// simple sanity check: make sure all elements of the list are in sorted
+// order, that no marked node is still linked in, and that no lock is held
+bool LazyList::isSane(void) const
+{
+    const Node* prev(head);
+    const Node* curr(prev->m_next);
+    while (curr != NULL) {
+        if (curr->m_marked || curr->m_lock || (prev->m_val >= curr->m_val))
+            return false;
+        prev = curr;
+        curr = curr->m_next;
+    }
+    return prev->m_val == INT_MAX;
+}
+
+// walk to the first node >= val, without taking any locks
+void LazyList::find(int val, Node*& pred, Node*& curr) const
+{
+    pred = head;
+    curr = pred->m_next.load();
+    while (curr->m_val < val) {
+        pred = curr;
+        curr = curr->m_next.load();
+    }
+}
+
+// pred and curr are locked: they are only usable if neither has been removed
+// and pred still points to curr
+bool LazyList::validate(const Node* pred, const Node* curr)
+{
+    return !pred->m_marked.load() && !curr->m_marked.load()
+        && (pred->m_next.load() == curr);
+}
+
+// search function; no locks, no retries
+bool LazyList::lookup(int val) const
+{
+    epoch_reclaimer& r = const_cast<epoch_reclaimer&>(reclaimer);
+    r.enter();
+    Node* pred;
+    Node* curr;
+    find(val, pred, curr);
+    bool found = (curr->m_val == val) && !curr->m_marked.load();
+    r.exit();
+    return found;
+}
+
+// insert method; lock the pair that val goes between, validate, and link
+bool LazyList::insert(int val)
+{
+    reclaimer.enter();
+    while (true) {
+        Node* pred;
+        Node* curr;
+        find(val, pred, curr);
+        pred->lock();
+        curr->lock();
+        if (!validate(pred, curr)) {
+            curr->unlock();
+            pred->unlock();
+            continue;
+        }
+        bool ok = curr->m_val != val;
+        if (ok)
+            pred->m_next.store(new_node(val, curr));
+        curr->unlock();
+        pred->unlock();
+        reclaimer.exit();
+        return ok;
+    }
+}
+
+// remove a node if its value == val: mark it, then unlink it
+bool LazyList::remove(int val)
+{
+    reclaimer.enter();
+    while (true) {
+        Node* pred;
+        Node* curr;
+        find(val, pred, curr);
+        pred->lock();
+        curr->lock();
+        if (!validate(pred, curr)) {
+            curr->unlock();
+            pred->unlock();
+            continue;
+        }
+        bool ok = curr->m_val == val;
+        if (ok) {
+            curr->m_marked.store(true);
+            pred->m_next.store(curr->m_next.load());
+        }
+        curr->unlock();
+        pred->unlock();
+        if (ok)
+            reclaimer.retire(curr, sizeof(Node));
+        reclaimer.exit();
+        return ok;
+    }
+}
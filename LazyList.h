@@ -0,0 +1,82 @@
+// -*-c++-*-
+
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "reclaim.h"
+
+// Lazy sorted linked list (Heller et al.).  Updates lock the two nodes they
+// touch and then validate that both are still linked and adjacent; a removed
+// node is first marked and then unlinked, so lookups take no locks and never
+// retry.  Like HarrisList, this is a non-TM reference point for List.
+class LazyList
+{
+    // Node in a LazyList
+    struct Node
+    {
+        int                m_val;
+        std::atomic<Node*> m_next;
+        std::atomic<bool>  m_marked;
+        std::atomic<bool>  m_lock;
+
+        Node(int val, Node* next)
+            : m_val(val), m_next(next), m_marked(false), m_lock(false) { }
+
+        void lock() {
+            while (m_lock.exchange(true, std::memory_order_acquire))
+                while (m_lock.load(std::memory_order_relaxed)) { }
+        }
+        void unlock() { m_lock.store(false, std::memory_order_release); }
+    };
+
+    // nodes are malloc'd, since the reclaimer free()s them
+    static Node* new_node(int val, Node* next) {
+        return new (malloc(sizeof(Node))) Node(val, next);
+    }
+
+    // sentinels at INT_MIN and INT_MAX, so every key has a pred and a succ
+    Node* head;
+
+    // unlinked nodes wait here until no one can be looking at them
+    epoch_reclaimer reclaimer;
+
+    // unlocked search: pred is the last node < val, curr the first >= val
+    void find(int val, Node*& pred, Node*& curr) const;
+
+    // with pred and curr locked, check that they are still adjacent and live
+    static bool validate(const Node* pred, const Node* curr);
+
+  public:
+
+    // the harness runs our operations directly, not in transactions
+    static const bool concurrent = true;
+
+    // the reclaimer has a record per thread_id
+    static const int max_threads = RECLAIM_MAX_THREADS;
+
+    LazyList();
+
+    // true iff val is in the data structure
+    bool lookup(int val) const;
+
+    // standard IntSet methods
+    bool insert(int val);
+
+    // remove a node if its value = val
+    bool remove(int val);
+
+    // make sure the list is in sorted order, with no marked nodes
+    bool isSane() const;
+};
@@ -1,17 +1,20 @@
-#include <climits>
 #include "List.h"
+#include "image.h"
+#include "payload.h"
 
 // constructor just makes a sentinel for the data structure
-List::List() : sentinel(new Node()) { }
+template<class K, class V>
+ListMap<K,V>::ListMap() : sentinel(new Node()) { }
 
 // simple sanity check: make sure all elements of the list are in sorted order
-bool List::isSane(void) const
+template<class K, class V>
+bool ListMap<K,V>::isSane(void) const
 {
     const Node* prev(sentinel);
     const Node* curr((prev->m_next));
 
     while (curr != NULL) {
-        if ((prev->m_val) >= (curr->m_val))
+        if (!((prev->m_val) < (curr->m_val)))
             return false;
         prev = curr;
         curr = curr->m_next;
@@ -21,12 +24,13 @@ bool List::isSane(void) const
 
 // extended sanity check, does the same as the above method, but also calls v()
 // on every item in the list
-bool List::extendedSanityCheck(verifier v, uint32_t v_param) const
+template<class K, class V>
+bool ListMap<K,V>::extendedSanityCheck(verifier v, uint32_t v_param) const
 {
     const Node* prev(sentinel);
     const Node* curr((prev->m_next));
     while (curr != NULL) {
-        if (!v((curr->m_val), v_param) || ((prev->m_val) >= (curr->m_val)))
+        if (!v((curr->m_val), v_param) || !((prev->m_val) < (curr->m_val)))
             return false;
         prev = curr;
         curr = prev->m_next;
@@ -36,26 +40,28 @@ bool List::extendedSanityCheck(verifier v, uint32_t v_param) const
 
 // insert method; find the right place in the list, add val so that it is in
 // sorted order; if val is already in the list, exit without inserting
-bool List::insert(int val)
+template<class K, class V>
+bool ListMap<K,V>::insert(const K& val)
 {
     // traverse the list to find the insertion point
     const Node* prev(sentinel);
     const Node* curr(prev->m_next);
 
     while (curr != NULL) {
-        if ((curr->m_val) >= val)
+        if (!((curr->m_val) < val))
             break;
         prev = curr;
         curr = (prev->m_next);
     }
 
     // now insert new_node between prev and curr
-    if (!curr || ((curr->m_val) > val)) {
+    if (!curr || (val < (curr->m_val))) {
         Node* insert_point = const_cast<Node*>(prev);
 
         // create the new node
         Node* i = (Node*)malloc(sizeof(Node));
         i->m_val = val;
+        i->m_data = V();
         i->m_next = const_cast<Node*>(curr);
         insert_point->m_next = i;
         return true;
@@ -66,14 +72,15 @@ bool List::insert(int val)
 }
 
 // search function
-bool List::lookup(int val) const
+template<class K, class V>
+bool ListMap<K,V>::lookup(const K& val) const
 {
     bool found = false;
     const Node* curr(sentinel);
     curr = (curr->m_next);
 
     while (curr != NULL) {
-        if ((curr->m_val) >= val)
+        if (!((curr->m_val) < val))
             break;
         curr = (curr->m_next);
     }
@@ -82,10 +89,67 @@ bool List::lookup(int val) const
     return found;
 }
 
+// the search that the map methods share
+template<class K, class V>
+typename ListMap<K,V>::Node* ListMap<K,V>::find(const K& val, Node*& prev) const
+{
+    prev = sentinel;
+    Node* curr(prev->m_next);
+    while ((curr != NULL) && ((curr->m_val) < val)) {
+        prev = curr;
+        curr = (curr->m_next);
+    }
+    return ((curr != NULL) && ((curr->m_val) == val)) ? curr : NULL;
+}
+
+// copy val's data out, if val is in the list
+template<class K, class V>
+bool ListMap<K,V>::get(const K& val, V& data) const
+{
+    Node* prev;
+    const Node* curr = find(val, prev);
+    if (curr == NULL)
+        return false;
+    data = (curr->m_data);
+    return true;
+}
+
+// set val's data, linking in a new node after prev if val is not in the
+// list
+template<class K, class V>
+bool ListMap<K,V>::insert_or_assign(const K& val, const V& data)
+{
+    Node* prev;
+    Node* curr = find(val, prev);
+    if (curr != NULL) {
+        curr->m_data = data;
+        return false;
+    }
+    Node* i = (Node*)malloc(sizeof(Node));
+    i->m_val = val;
+    i->m_data = data;
+    i->m_next = (prev->m_next);
+    prev->m_next = i;
+    return true;
+}
+
+// overwrite val's data, if val is in the list
+template<class K, class V>
+bool ListMap<K,V>::update(const K& val, const V& data)
+{
+    Node* prev;
+    Node* curr = find(val, prev);
+    if (curr == NULL)
+        return false;
+    curr->m_data = data;
+    return true;
+}
+
 // findmax function
-int List::findmax() const
+template<class K, class V>
+K ListMap<K,V>::findmax() const
 {
-    int max = -1;
+    K max = K(-1);
     const Node* curr(sentinel);
     while (curr != NULL) {
         max = (curr->m_val);
@@ -95,9 +159,10 @@ int List::findmax() const
 }
 
 // findmin function
-int List::findmin() const
+template<class K, class V>
+K ListMap<K,V>::findmin() const
 {
-    int min = -1;
+    K min = K(-1);
     const Node* curr(sentinel);
     curr = (curr->m_next);
     if (curr != NULL)
@@ -106,7 +171,8 @@ int List::findmin() const
 }
 
 // remove a node if its value == val
-bool List::remove(int val)
+template<class K, class V>
+bool ListMap<K,V>::remove(const K& val)
 {
     // find the node whose val matches the request
     const Node* prev(sentinel);
@@ -121,7 +187,7 @@ bool List::remove(int val)
             free(const_cast<Node*>(curr));
             return true;
         }
-        else if ((curr->m_val) > val) {
+        else if (val < (curr->m_val)) {
             break;
         }
         prev = curr;
@@ -131,16 +197,91 @@ bool List::remove(int val)
 }
 
 // search function
-void List::overwrite(int val)
+template<class K, class V>
+void ListMap<K,V>::overwrite(const K& val)
 {
     const Node* curr(sentinel);
     curr = (curr->m_next);
 
     while (curr != NULL) {
-        if ((curr->m_val) >= val)
+        if (!((curr->m_val) < val))
             break;
         Node* wcurr = const_cast<Node*>(curr);
         wcurr->m_val = (wcurr->m_val);
         curr = (wcurr->m_next);
     }
 }
+
+// write the list to an image; node i's successor is node i+1
+template<class K, class V>
+bool ListMap<K,V>::save_image(const char* path, uint64_t elements) const
+{
+    image_writer w(path, "ListMap", sizeof(Node), elements);
+    if (!w.ok())
+        return false;
+    image_put(w, 0);
+    return w.finish();
+}
+
+// map an image and relocate its pointers; the sentinel is node 0
+template<class K, class V>
+bool ListMap<K,V>::load_image(const char* path, uint64_t elements)
+{
+    uint64_t n;
+    char* base = image_map(path, "ListMap", sizeof(Node), elements, n);
+    if (!base)
+        return false;
+    if (image_end(base, 0, n) != n) {
+        image_unmap(base, sizeof(Node), n);
+        return false;
+    }
+    image_take(base, 0);
+    return true;
+}
+
+template<class K, class V>
+uint32_t ListMap<K,V>::image_node_size()
+{
+    return sizeof(Node);
+}
+
+// append the list, sentinel first, as nodes i, i+1, ...
+template<class K, class V>
+uint64_t ListMap<K,V>::image_put(image_writer& w, uint64_t i) const
+{
+    for (const Node* curr = sentinel; curr != NULL; curr = curr->m_next) {
+        Node n(curr->m_val, curr->m_next ? image_offset<Node>(++i) : NULL);
+        n.m_data = curr->m_data;
+        w.put(&n);
+    }
+    return i + 1;
+}
+
+// the list at node i ends at the first node with no successor
+template<class K, class V>
+uint64_t ListMap<K,V>::image_end(char* base, uint64_t i, uint64_t n)
+{
+    Node* nodes = (Node*)(base + sizeof(ImageHeader));
+    for (; i < n; ++i)
+        if (nodes[i].m_next == NULL)
+            return i + 1;
+    return 0;
+}
+
+// relocate the list at node i, and make it this list
+template<class K, class V>
+uint64_t ListMap<K,V>::image_take(char* base, uint64_t i)
+{
+    Node* nodes = (Node*)(base + sizeof(ImageHeader));
+    delete sentinel;
+    sentinel = &nodes[i];
+    for (; nodes[i].m_next != NULL; ++i)
+        image_relocate(base, nodes[i].m_next);
+    return i + 1;
+}
+
+// the maps the benchmarks use
+template class ListMap<int, NoValue>;
+template class ListMap<int, int>;
+#define LISTMAP_PAYLOAD(N) template class ListMap<int, Payload<N> >;
+PAYLOAD_SIZES(LISTMAP_PAYLOAD)
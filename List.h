@@ -14,45 +14,74 @@
 
 #include <cstdlib>
 #include <cstdint>
+#include "novalue.h"
 
 // We construct other data structures from the List. In order to do their
 // sanity checks correctly, we might need to pass in a validation function of
 // this type
 typedef bool (*verifier)(uint32_t, uint32_t);
 
-// Set of LLNodes represented as a linked list in sorted order
-class List
+class image_writer;
+
+// Map from K to V, as a linked list in sorted order of K.  Keys need < and
+// ==, and for findmax/findmin and the sanity check, conversion to and from
+// int.  List, the IntSet the benchmarks use, is a ListMap<int, NoValue>;
+// List.cc instantiates that, ListMap<int, int>, and one map per Payload size
+// (see payload.h).
+template<class K, class V>
+class ListMap
 {
 
-  // Node in a List
+  // Node in a ListMap.  The link and key come first, so that a large m_data
+  // doesn't push them onto another cache line.
   struct Node
   {
-      int m_val;
       Node* m_next;
+      K     m_val;
+      [[no_unique_address]]
+      V     m_data;
 
       // ctors
-      Node(int val = -1) : m_val(val), m_next() { }
+      Node(const K& val = K(-1)) : m_next(), m_val(val), m_data() { }
 
-      Node(int val, Node* next) : m_val(val), m_next(next) { }
+      Node(const K& val, Node* next) : m_next(next), m_val(val), m_data() { }
   };
 
     Node* sentinel;
 
+    // the node holding val, or NULL; on return prev is the last node < val
+    __attribute__((transaction_safe))
+    Node* find(const K& val, Node*& prev) const;
+
   public:
 
-    List();
+    ListMap();
 
     // true iff val is in the data structure
     __attribute__((transaction_safe))
-    bool lookup(int val) const;
+    bool lookup(const K& val) const;
 
     // standard IntSet methods
     __attribute__((transaction_safe))
-    bool insert(int val);
+    bool insert(const K& val);
 
     // remove a node if its value = val
     __attribute__((transaction_safe))
-    bool remove(int val);
+    bool remove(const K& val);
+
+    // map methods, which copy values in and out
+
+    // copy val's data out to data; false if val is not present
+    __attribute__((transaction_safe))
+    bool get(const K& val, V& data) const;
+
+    // "put": set val's data, inserting val if needed; true iff inserted
+    __attribute__((transaction_safe))
+    bool insert_or_assign(const K& val, const V& data);
+
+    // set val's data only if val is present; true iff it was
+    __attribute__((transaction_safe))
+    bool update(const K& val, const V& data);
 
     // make sure the list is in sorted order
     bool isSane() const;
@@ -63,12 +92,30 @@ class List
 
     // find max and min
     __attribute__((transaction_safe))
-    int findmax() const;
+    K findmax() const;
 
     __attribute__((transaction_safe))
-    int findmin() const;
+    K findmin() const;
 
     // overwrite all elements up to val
     __attribute__((transaction_safe))
-    void overwrite(int val);
+    void overwrite(const K& val);
+
+    // write the list to an image file, or replace this (empty) list with
+    // the one in an image file; see image.h
+    bool save_image(const char* path, uint64_t elements) const;
+    bool load_image(const char* path, uint64_t elements);
+
+    // for images that hold several lists back to back (HashMap): the node
+    // size, appending this list as nodes i, i+1, ..., finding the end of
+    // the list at node i of n in a mapped image (0 if it runs off the end),
+    // and replacing this list with that one.  The last three return the
+    // index after the list.
+    static uint32_t image_node_size();
+    uint64_t image_put(image_writer& w, uint64_t i) const;
+    static uint64_t image_end(char* base, uint64_t i, uint64_t n);
+    uint64_t image_take(char* base, uint64_t i);
 };
+
+// the integer set that the benchmarks use
+typedef ListMap<int, NoValue> List;
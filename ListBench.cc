@@ -11,9 +11,9 @@
 #include "bmconfig.h"
 #include "bmharness.h"
 #include "List.h"
-
-/// This is the list we will manipulate in this experiment
-benchmark<List> SET;
+#include "HarrisList.h"
+#include "LazyList.h"
+#include "payload.h"
 
 /// This static, declared in bmconfig, needs to be defined
 Config Config::CFG;
@@ -21,21 +21,51 @@ Config Config::CFG;
 /// A helper function to update the configuration based on some custom names
 void reparse_args()
 {
-    if      (Config::CFG.bmname == "")     Config::CFG.bmname   = "List";
-    else if (Config::CFG.bmname == "List") Config::CFG.elements = 256;
+    if      (Config::CFG.bmname == "")         Config::CFG.bmname   = "List";
+    else if (Config::CFG.bmname == "List")     Config::CFG.elements = 256;
+    else if (Config::CFG.bmname == "HMList")   Config::CFG.elements = 256;
+    else if (Config::CFG.bmname == "LazyList") Config::CFG.elements = 256;
 }
 
-/// We just call to SET functions in main
-int main(int argc, char** argv) {
-    // parse command line
-    Config::CFG.parseargs(argc, argv, "ListBench");
-    reparse_args();
+/// Build, warm up, and test a list of type L
+template<class L>
+void run_list()
+{
+    // This is the list we will manipulate in this experiment
+    benchmark<L> SET;
 
     // warm up the data structure
     SET.warmup();
 
     // run the tests
     SET.launch_test();
+}
+
+/// With -V, the list is a map to values of that many bytes
+struct run_map
+{
+    template<class V>
+    void run() { run_list<PayloadSet<ListMap<int, V>, V> >(); }
+};
+
+/// We just call to SET functions in main
+int main(int argc, char** argv) {
+    // parse command line
+    Config::CFG.parseargs(argc, argv, "ListBench");
+    reparse_args();
+
+    // the transactional list, or one of the non-TM reference lists
+    if (Config::CFG.bmname == "HMList")
+        run_list<HarrisList>();
+    else if (Config::CFG.bmname == "LazyList")
+        run_list<LazyList>();
+    else if (!Config::CFG.value_size)
+        run_list<List>();
+    else if (!with_payload(Config::CFG.value_size, run_map())) {
+        std::cerr << "Unsupported value size " << Config::CFG.value_size
+                  << "\n";
+        exit(1);
+    }
 
     // print results
     Config::CFG.dump_csv();
@@ -0,0 +1,37 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+/**
+ * A set that does nothing, for measuring everything but the set.  With TM
+ * false it declares itself concurrent, so the harness calls it with no
+ * transaction at all, and what is left is the harness: the RNG, the mix,
+ * the counters, and polling the running flag.  With TM true every
+ * operation is an empty transaction, which adds just TM begin and commit.
+ */
+template<bool TM>
+class NullSet
+{
+  public:
+
+    static const bool concurrent = !TM;
+
+    __attribute__((transaction_safe))
+    bool lookup(int) const { return false; }
+
+    __attribute__((transaction_safe))
+    bool insert(int) { return false; }
+
+    __attribute__((transaction_safe))
+    bool remove(int) { return false; }
+
+    bool isSane() const { return true; }
+};
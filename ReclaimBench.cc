@@ -0,0 +1,66 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#include "bmconfig.h"
+#include "bmharness.h"
+#include "ReclaimSet.h"
+
+/// This static, declared in bmconfig, needs to be defined
+Config Config::CFG;
+
+/// A helper function to update the configuration based on some custom names
+void reparse_args()
+{
+    if      (Config::CFG.bmname == "")      Config::CFG.bmname   = "EBR";
+    else if (Config::CFG.bmname == "EBR")   Config::CFG.elements = 256;
+    else if (Config::CFG.bmname == "HP")    Config::CFG.elements = 256;
+    else if (Config::CFG.bmname == "EBR1K") Config::CFG.elements = 1024;
+    else if (Config::CFG.bmname == "HP1K")  Config::CFG.elements = 1024;
+}
+
+/// Build, warm up, and test a ReclaimSet using R, then report what R did
+template<class R>
+void run_reclaim()
+{
+    ReclaimSet<R>* set = new ReclaimSet<R>(Config::CFG.elements);
+    benchmark<ReclaimSet<R>> SET(set);
+
+    // warm up the data structure
+    SET.warmup();
+
+    // run the tests
+    SET.launch_test();
+
+    // the reclaimer's side of the story
+    ReclaimStats s = set->stats();
+    std::cout << "reclaim, retired=" << s.retired << ", freed=" << s.freed
+              << ", pending=" << (s.retired - s.freed)
+              << ", deferred_bytes=" << (s.bytes_retired - s.bytes_freed)
+              << ", peak_deferred_bytes=" << s.peak_deferred
+              << ", avg_latency=" << (s.freed ? s.latency_sum / s.freed : 0)
+              << ", max_latency=" << s.latency_max
+              << ", frees/sec="
+              << (uint64_t)(s.freed * 1e9 / Config::CFG.time) << std::endl;
+}
+
+/// We just call to SET functions in main
+int main(int argc, char** argv) {
+    // parse command line
+    Config::CFG.parseargs(argc, argv, "ReclaimBench");
+    reparse_args();
+
+    if (Config::CFG.bmname.substr(0, 2) == "HP")
+        run_reclaim<hazard_reclaimer>();
+    else
+        run_reclaim<epoch_reclaimer>();
+
+    // print results
+    Config::CFG.dump_csv();
+}
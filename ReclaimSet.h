@@ -0,0 +1,100 @@
+// -*-c++-*-
+
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include "reclaim.h"
+
+// A set that exists to exercise a reclaimer R: slot i of an array holds
+// either NULL or a node for key i.  Lookups protect() and read the node,
+// removes swap in NULL and retire the old node, and inserts always swap in a
+// fresh node (retiring any old one), so nearly every update is a retire.
+// Membership still behaves like an IntSet, so the harness can drive it.
+template<class R>
+class ReclaimSet
+{
+    // a small node, about the size of a List node with a payload
+    struct Node
+    {
+        int m_val;
+        int m_data[7];
+    };
+
+    std::atomic<Node*>* slots;
+    uint32_t            size;
+
+    R reclaimer;
+
+  public:
+
+    // the harness runs our operations directly, not in transactions
+    static const bool concurrent = true;
+
+    // the reclaimer has a record per thread_id
+    static const int max_threads = RECLAIM_MAX_THREADS;
+
+    // keys run from 0 to _size inclusive: warmup inserts _size itself
+    ReclaimSet(uint32_t _size)
+        : slots(new std::atomic<Node*>[_size + 1]), size(_size + 1)
+    {
+        for (uint32_t i = 0; i < size; ++i)
+            slots[i].store(NULL, std::memory_order_relaxed);
+    }
+
+    // true iff val is in the data structure
+    bool lookup(int val) {
+        reclaimer.enter();
+        const Node* n = reclaimer.protect(0, slots[val]);
+        bool found = (n != NULL) && (n->m_val == val);
+        reclaimer.exit();
+        return found;
+    }
+
+    // replace val's node with a new one; true if val wasn't there before
+    bool insert(int val) {
+        Node* n = (Node*)malloc(sizeof(Node));
+        n->m_val = val;
+        reclaimer.enter();
+        Node* old = slots[val].exchange(n);
+        if (old != NULL)
+            reclaimer.retire(old, sizeof(Node));
+        reclaimer.exit();
+        return old == NULL;
+    }
+
+    // take val's node out, if there is one
+    bool remove(int val) {
+        reclaimer.enter();
+        Node* old = slots[val].exchange(NULL);
+        if (old != NULL)
+            reclaimer.retire(old, sizeof(Node));
+        reclaimer.exit();
+        return old != NULL;
+    }
+
+    // every node is in its own slot
+    bool isSane() const {
+        for (uint32_t i = 0; i < size; ++i) {
+            const Node* n = slots[i].load();
+            if ((n != NULL) && (n->m_val != (int)i))
+                return false;
+        }
+        return true;
+    }
+
+    // totals from the reclaimer, once the threads are done
+    ReclaimStats stats() const { return reclaimer.stats(); }
+};
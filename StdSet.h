@@ -1,6 +1,10 @@
 #pragma once
 
+#include <map>
 #include <set>
+#include <unordered_set>
+#include <cstdlib>
+#include <cstddef>
 
 class StdSet
 {
@@ -38,6 +42,149 @@ class StdSet
             s.insert(val);
     }
 
+    // remove val if present, else insert it, with one search: the insert
+    // hands back the existing element, which we erase by position
+    __attribute__((transaction_safe))
+    bool toggle(int val)
+    {
+        auto r = s.insert(val);
+        if (!r.second)
+            s.erase(r.first);
+        return r.second;
+    }
+
+    bool isSane() const
+    {
+        return true;
+    }
+};
+
+// An allocator that gets memory from malloc and free, which GCC's TM
+// runtime knows how to undo, instead of from operator new
+template<class T>
+struct tm_allocator
+{
+    typedef T value_type;
+
+    tm_allocator() { }
+    template<class U> tm_allocator(const tm_allocator<U>&) { }
+
+    __attribute__((transaction_safe))
+    T* allocate(size_t n) { return (T*)malloc(n * sizeof(T)); }
+
+    __attribute__((transaction_safe))
+    void deallocate(T* p, size_t) { free(p); }
+
+    template<class U> bool operator==(const tm_allocator<U>&) const { return true; }
+    template<class U> bool operator!=(const tm_allocator<U>&) const { return false; }
+};
+
+class StdUnorderedSet
+{
+    std::unordered_set<int, std::hash<int>, std::equal_to<int>,
+                       tm_allocator<int> > s;
+
+  public:
+
+    StdUnorderedSet() { }
+
+    // standard IntSet methods
+
+    __attribute__((transaction_safe))
+    bool lookup(int val) const
+    {
+        return s.find(val) != s.end();
+    }
+
+    __attribute__((transaction_safe))
+    bool insert(int val)
+    {
+        return s.insert(val).second;
+    }
+
+    __attribute__((transaction_safe))
+    bool remove(int val)
+    {
+        return s.erase(val) == 1;
+    }
+
+    __attribute__((transaction_safe))
+    bool toggle(int val)
+    {
+        auto r = s.insert(val);
+        if (!r.second)
+            s.erase(r.first);
+        return r.second;
+    }
+
+    bool isSane() const
+    {
+        return true;
+    }
+};
+
+// std::map from int keys to V, for the key/value benchmarks (-V)
+template<class V>
+class StdMap
+{
+    std::map<int, V, std::less<int>,
+             tm_allocator<std::pair<const int, V> > > m;
+
+  public:
+
+    StdMap() { }
+
+    // standard IntSet methods
+
+    __attribute__((transaction_safe))
+    bool lookup(int val) const
+    {
+        return m.find(val) != m.end();
+    }
+
+    __attribute__((transaction_safe))
+    bool insert(int val)
+    {
+        return m.insert(std::make_pair(val, V())).second;
+    }
+
+    __attribute__((transaction_safe))
+    bool remove(int val)
+    {
+        return m.erase(val) == 1;
+    }
+
+    // map methods
+
+    __attribute__((transaction_safe))
+    bool get(int val, V& data) const
+    {
+        auto i = m.find(val);
+        if (i == m.end())
+            return false;
+        data = i->second;
+        return true;
+    }
+
+    __attribute__((transaction_safe))
+    bool insert_or_assign(int val, const V& data)
+    {
+        auto r = m.insert(std::make_pair(val, data));
+        if (!r.second)
+            r.first->second = data;
+        return r.second;
+    }
+
+    __attribute__((transaction_safe))
+    bool update(int val, const V& data)
+    {
+        auto i = m.find(val);
+        if (i == m.end())
+            return false;
+        i->second = data;
+        return true;
+    }
+
     bool isSane() const
     {
         return true;
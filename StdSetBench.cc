@@ -1,35 +1,116 @@
 #include "bmconfig.h"
 #include "bmharness.h"
-#include "StdSet.h"
+#include "FlatSet.h"
 
-/// This is the tree we will manipulate in this experiment
-benchmark<StdSet> SET;
+/// GCC's TM can only run the std containers with a standard library whose
+/// containers are transaction_safe; build with -DTM_STDLIB for one that is.
+/// Without it, this runs just the FlatSets.
+#ifdef TM_STDLIB
+#include "StdSet.h"
+#include "payload.h"
+#endif
 
 /// This static, declared in bmconfig, needs to be defined
 Config Config::CFG;
 
+/// The size presets, which follow any of the set names (e.g., Flat1K).  No
+/// suffix means 256.
+static const char* SIZE_NAMES[] = { "", "16", "256", "1K", "64K", "1M" };
+static const uint32_t SIZES[]   = { 256, 16, 256, 1024, 65536, 1048576 };
+
+/// The sets: std::set, a packed FlatSet, a FlatSet with a gap, and
+/// std::unordered_set
+static const char* SET_NAMES[] = { "StdSet", "FlatGap", "Flat", "Unordered" };
+
+/// Whether a set was built into this binary
+static bool have_set(const std::string& set)
+{
+#ifdef TM_STDLIB
+    return true;
+#else
+    return set == "Flat" || set == "FlatGap";
+#endif
+}
+
 /// A helper function to update the configuration based on some custom names
 void reparse_args() {
-    if      (Config::CFG.bmname == "")          Config::CFG.bmname   = "StdSet";
-    else if (Config::CFG.bmname == "StdSet")    Config::CFG.elements = 256;
-    else if (Config::CFG.bmname == "StdSet16")  Config::CFG.elements = 16;
-    else if (Config::CFG.bmname == "StdSet256") Config::CFG.elements = 256;
-    else if (Config::CFG.bmname == "StdSet1K")  Config::CFG.elements = 1024;
-    else if (Config::CFG.bmname == "StdSet64K") Config::CFG.elements = 65536;
-    else if (Config::CFG.bmname == "StdSet1M")  Config::CFG.elements = 1048576;
+    if (Config::CFG.bmname == "")
+        Config::CFG.bmname = have_set("StdSet") ? "StdSet" : "Flat";
+    for (const char* set : SET_NAMES) {
+        std::string prefix(set);
+        if (Config::CFG.bmname.compare(0, prefix.size(), prefix) != 0)
+            continue;
+        if (!have_set(prefix)) {
+            std::cerr << prefix << " needs a build with -DTM_STDLIB\n";
+            exit(1);
+        }
+        std::string suffix = Config::CFG.bmname.substr(prefix.size());
+        for (int i = 0; i < 6; ++i) {
+            if (suffix == SIZE_NAMES[i]) {
+                Config::CFG.elements = SIZES[i];
+                return;
+            }
+        }
+    }
+    std::cerr << "Unknown set " << Config::CFG.bmname << "\n";
+    exit(1);
 }
 
-/// We just call to SET functions in main
-int main(int argc, char** argv) {
-    // parse command line
-    Config::CFG.parseargs(argc, argv, "StdSetBench");
-    reparse_args();
+/// Build, warm up, and test a set of type S
+template<class S>
+void run_set(S* set)
+{
+    benchmark<S> SET(set);
 
     // warm up the data structure
     SET.warmup();
 
     // run the tests
     SET.launch_test();
+}
+
+#ifdef TM_STDLIB
+/// With -V, StdSet becomes a std::map to values of that many bytes
+struct run_map
+{
+    template<class V>
+    void run() { run_set(new PayloadSet<StdMap<V>, V>()); }
+};
+#endif
+
+/// We just call to SET functions in main
+int main(int argc, char** argv) {
+    // parse command line
+    Config::CFG.parseargs(argc, argv, "StdSetBench");
+    reparse_args();
+
+    std::string name = Config::CFG.bmname;
+    if (Config::CFG.value_size) {
+#ifdef TM_STDLIB
+        if (name.compare(0, 6, "StdSet") != 0) {
+            std::cerr << "Only StdSet has a map version for -V\n";
+            exit(1);
+        }
+        if (!with_payload(Config::CFG.value_size, run_map())) {
+            std::cerr << "Unsupported value size " << Config::CFG.value_size
+                      << "\n";
+            exit(1);
+        }
+#else
+        std::cerr << "Only StdSet has a map version for -V\n";
+        exit(1);
+#endif
+    }
+    else if (name.compare(0, 7, "FlatGap") == 0)
+        run_set(new FlatSet(true));
+    else if (name.compare(0, 4, "Flat") == 0)
+        run_set(new FlatSet(false));
+#ifdef TM_STDLIB
+    else if (name.compare(0, 9, "Unordered") == 0)
+        run_set(new StdUnorderedSet());
+    else
+        run_set(new StdSet());
+#endif
 
     // print results
     Config::CFG.dump_csv();
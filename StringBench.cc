@@ -0,0 +1,129 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "bmconfig.h"
+#include "bmharness.h"
+#include "Tree.h"
+#include "strkey.h"
+
+/// This static, declared in bmconfig, needs to be defined
+Config Config::CFG;
+
+/**
+ * A tree keyed by strings, behind the IntSet interface that the harness
+ * drives: the integer i stands for key i of a key space made up front, so
+ * the usual -m, -R and -O mean what they always do.  The key space is made
+ * in parallel, each thread filling a slice of it from its own arena.
+ */
+class StrTree
+{
+    RBMap<StrKey, int>     tree;
+    StrKey*                keys;
+    std::vector<StrArena*> arenas;
+
+  public:
+
+    uint32_t nkeys;
+    uint64_t key_bytes;     /// total length of all keys
+    uint64_t build_time;
+    uint64_t prefix_ties;   /// sorted neighbors with the same 8-byte prefix
+
+    /// keys 0 .. n (the harness warms up with n itself)
+    StrTree(const StrKeyGen& gen, uint32_t n, uint32_t threads)
+        : keys(new StrKey[n + 1]), arenas(threads), nkeys(n + 1),
+          key_bytes(0), prefix_ties(0)
+    {
+        uint64_t start = getElapsedTime();
+        std::vector<std::thread> builders;
+        for (uint32_t t = 0; t < threads; ++t)
+            builders.push_back(std::thread([this, &gen, t, threads] {
+                arenas[t] = new StrArena();
+                uint32_t lo = (uint64_t)nkeys * t / threads;
+                uint32_t hi = (uint64_t)nkeys * (t + 1) / threads;
+                for (uint32_t i = lo; i < hi; ++i)
+                    keys[i] = gen.make(i, *arenas[t]);
+            }));
+        for (std::thread& b : builders)
+            b.join();
+        build_time = getElapsedTime() - start;
+
+        // how often the inline prefix can't decide a comparison
+        std::vector<StrKey> sorted(keys, keys + nkeys);
+        std::sort(sorted.begin(), sorted.end());
+        for (uint32_t i = 1; i < nkeys; ++i)
+            prefix_ties += (sorted[i].prefix == sorted[i - 1].prefix);
+        for (StrArena* a : arenas)
+            key_bytes += a->bytes;
+    }
+
+    ~StrTree() {
+        for (StrArena* a : arenas)
+            delete a;
+        delete[] keys;
+    }
+
+    bool lookup(int i) const { return tree.lookup(keys[i]); }
+    bool insert(int i)       { return tree.insert(keys[i]); }
+    bool remove(int i)       { return tree.remove(keys[i]); }
+    bool isSane() const      { return tree.isSane(); }
+
+    bool verify(uint32_t threads, uint32_t sample) const {
+        return tree.verify(threads, sample);
+    }
+};
+
+/// Names are a structure and a key length distribution (see strkey.h), e.g.
+/// RBTree-url or RBTree-fixed32.  RBTree is the only ordered structure that
+/// takes string keys so far.
+StrKeyGen* reparse_args()
+{
+    if (Config::CFG.bmname == "") Config::CFG.bmname = "RBTree-short";
+
+    std::string name = Config::CFG.bmname;
+    size_t dash = name.find('-');
+    StrKeyGen* gen = NULL;
+    if (name.substr(0, dash) == "RBTree" && dash != std::string::npos)
+        gen = StrKeyGen::parse(name.substr(dash + 1));
+    if (!gen) {
+        std::cerr << "Unknown workload " << name << "\n";
+        exit(1);
+    }
+    return gen;
+}
+
+/// We just call to SET functions in main
+int main(int argc, char** argv) {
+    // parse command line
+    Config::CFG.parseargs(argc, argv, "StringBench");
+    StrKeyGen* gen = reparse_args();
+
+    StrTree* tree = new StrTree(*gen, Config::CFG.elements,
+                                Config::CFG.threads);
+    std::cout << "strkeys, dist=" << gen->name()
+              << ", keys=" << tree->nkeys
+              << ", avg_len=" << (double)tree->key_bytes / tree->nkeys
+              << ", key_bytes=" << tree->key_bytes
+              << ", prefix_ties=" << 100.0 * tree->prefix_ties / tree->nkeys
+              << "%, build=" << tree->build_time << std::endl;
+
+    benchmark<StrTree> SET(tree);
+
+    // warm up the data structure
+    SET.warmup();
+
+    // run the tests
+    SET.launch_test();
+
+    // print results
+    Config::CFG.dump_csv();
+}
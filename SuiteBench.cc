@@ -0,0 +1,270 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include "bmconfig.h"
+#include "bmharness.h"
+#include "Tree.h"
+#include "List.h"
+#include "DList.h"
+#include "UnrolledList.h"
+#include "FlatSet.h"
+#include "HarrisList.h"
+#include "LazyList.h"
+#include "Hash.h"
+#include "Counter.h"
+#include "Disjoint.h"
+
+/// This static, declared in bmconfig, needs to be defined
+Config Config::CFG;
+
+/**
+ * Runs a whole matrix of configurations in one process.  The spec is a file
+ * of axes, one per line, each a list of values:
+ *
+ *   # comment
+ *   set    = RBTree List Hash Counter DrDw-10-10-0
+ *   m      = 256 65536
+ *   R      = 34 90
+ *   p      = 1 2 4
+ *   trials = 3
+ *
+ * and every combination is a point.  An axis that is left out takes its
+ * value from the command line, whose other flags (-d, -X, -E, -H, ...) apply
+ * to every point.  Each trial of each point appends a record to the results
+ * store (-o, default suite.results), and the trials of a point are summed
+ * up when it is done.
+ *
+ * A structure is built and warmed once per set and m, and then shared by
+ * every R and p, since an even insert/remove split keeps it near half full.
+ * Structures sized by the thread count (and all of them under -M owner,
+ * whose warmup depends on it) are made again for each p.  None of the
+ * structures can be freed, so an old one is just dropped.
+ *
+ * std::set and std::unordered_set aren't here: GCC's TM can't compile
+ * them, which is also why StdSetBench leaves them out unless it is built
+ * with -DTM_STDLIB.
+ */
+
+/// A built structure, behind an interface that doesn't depend on its type
+struct SuiteSet
+{
+    virtual ~SuiteSet() { }
+    virtual void run() = 0;
+};
+
+template<class SET>
+struct SuiteSetOf : public SuiteSet
+{
+    benchmark<SET> bench;
+
+    SuiteSetOf(SET* set, bool warm) : bench(set) {
+        if (warm)
+            bench.warmup();
+    }
+
+    void run() { bench.launch_test(); }
+};
+
+template<class SET>
+SuiteSet* suite_set(SET* set, bool warm = true)
+{
+    return new SuiteSetOf<SET>(set, warm);
+}
+
+/// is name one of DisjointBench's?
+static bool disjoint_name(const std::string& name)
+{
+    return name.size() > 5 && name[4] == '-' && name.compare(2, 2, "Dw") == 0;
+}
+
+/// The structures, by name: Disjoint takes DisjointBench's names, and
+/// Sloppy takes CounterBench's (e.g., Sloppy-16)
+static SuiteSet* make_set(const std::string& name)
+{
+    uint32_t threads = Config::CFG.threads;
+    if (name == "RBTree")    return suite_set(new RBTree());
+    if (name == "List")      return suite_set(new List());
+    if (name == "HMList")    return suite_set(new HarrisList());
+    if (name == "LazyList")  return suite_set(new LazyList());
+    if (name == "UList")     return suite_set(new UnrolledList());
+    if (name == "DList")     return suite_set(new DList());
+    if (name == "Hash")      return suite_set(new HashTable());
+    if (name == "Flat")      return suite_set(new FlatSet(false));
+    if (name == "FlatGap")   return suite_set(new FlatSet(true));
+    if (name == "Counter")   return suite_set(new Counter());
+    if (name == "TMCounter") return suite_set(make_counter<TMCounter>());
+    if (name == "Atomic")    return suite_set(make_counter<AtomicCounter>());
+    if (name.compare(0, 6, "Sloppy") == 0) {
+        int threshold = SloppyCounter::parse(name);
+        return threshold
+            ? suite_set(make_counter<SloppyCounter>(threshold)) : NULL;
+    }
+    if (name == "Striped")
+        return suite_set(make_counter<StripedCounter>(threads));
+    if (name == "CTree")
+        return suite_set(new CombiningTreeCounter(threads));
+    if (name == "Null")      return suite_set(new NullSet<false>());
+    if (name == "EmptyTx")   return suite_set(new NullSet<true>());
+    if (disjoint_name(name)) {
+        Disjoint* dj = Disjoint::parse(name, Config::CFG.hugepages, threads);
+        return dj ? suite_set(dj, false) : NULL;
+    }
+    std::cerr << "Unknown structure " << name << "\n";
+    return NULL;
+}
+
+/// must a structure be made again when the thread count changes?
+static bool per_thread(const std::string& name)
+{
+    return name == "Striped" || name == "CTree" || disjoint_name(name)
+        || NumaPlacement::get().owner();
+}
+
+/// The matrix
+struct SuiteSpec
+{
+    std::vector<std::string> sets;
+    std::vector<uint32_t>    m, R, p;
+    uint32_t                 trials;
+
+    /// read a spec; false, after saying why, if it is wrong
+    bool load(const char* path) {
+        std::ifstream in(path);
+        if (!in) {
+            std::cerr << "Could not read " << path << "\n";
+            return false;
+        }
+        trials = 1;
+        std::string line;
+        for (int n = 1; std::getline(in, line); ++n) {
+            line = line.substr(0, line.find('#'));
+            size_t eq = line.find('=');
+            std::istringstream key(line.substr(0, eq));
+            std::string axis;
+            if (!(key >> axis))
+                continue;
+            std::istringstream vals(eq == line.npos ? "" : line.substr(eq + 1));
+            std::string v;
+            std::vector<std::string> values;
+            while (vals >> v)
+                values.push_back(v);
+            if (values.empty()) {
+                std::cerr << path << ":" << n << ": no values\n";
+                return false;
+            }
+            if (axis == "set")
+                sets = values;
+            else if (axis == "m" || axis == "R" || axis == "p") {
+                std::vector<uint32_t>& a = (axis == "m") ? m
+                                         : (axis == "R") ? R : p;
+                for (const std::string& s : values)
+                    a.push_back(strtol(s.c_str(), NULL, 10));
+            }
+            else if (axis == "trials")
+                trials = strtol(values[0].c_str(), NULL, 10);
+            else {
+                std::cerr << path << ":" << n << ": unknown axis " << axis
+                          << "\n";
+                return false;
+            }
+        }
+        if (sets.empty()) {
+            std::cerr << path << ": no sets\n";
+            return false;
+        }
+        if (m.empty()) m.push_back(Config::CFG.elements);
+        if (R.empty()) R.push_back(Config::CFG.lookpct);
+        if (p.empty()) p.push_back(Config::CFG.threads);
+        if (trials < 1) trials = 1;
+        return true;
+    }
+
+    uint32_t points() const {
+        return sets.size() * m.size() * R.size() * p.size();
+    }
+};
+
+/// Run every trial of the current point on set, and sum them up.  A run
+/// turns -E tm into direct for a concurrent set, so each starts from exec.
+static void run_point(SuiteSet* set, uint32_t trials, const std::string& exec)
+{
+    double sum = 0, sumsq = 0, lo = 0, hi = 0;
+    for (uint32_t t = 0; t < trials; ++t) {
+        Config::CFG.reset_counters();
+        Config::CFG.exec = exec;
+        set->run();
+        Config::CFG.dump_csv();
+        double tput = 1e9 * Config::CFG.txcount / Config::CFG.time;
+        sum += tput;
+        sumsq += tput * tput;
+        lo = t ? std::min(lo, tput) : tput;
+        hi = t ? std::max(hi, tput) : tput;
+    }
+    double mean = sum / trials;
+    double sd = (trials > 1)
+        ? std::sqrt(std::max(0.0, (sumsq - trials * mean * mean)
+                                  / (trials - 1)))
+        : 0;
+    std::cout << "suite, B=" << Config::CFG.bmname
+              << ", m=" << Config::CFG.elements
+              << ", R=" << Config::CFG.lookpct
+              << ", p=" << Config::CFG.threads
+              << ", trials=" << trials << ", mean=" << mean
+              << ", stddev=" << sd << ", min=" << lo << ", max=" << hi
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    // parse command line; what's left is the spec
+    Config::CFG.parseargs(argc, argv, "SuiteBench");
+    if (optind != argc - 1) {
+        std::cerr << "Usage: SuiteBench [flags] <matrix spec>\n";
+        exit(1);
+    }
+    if (Config::CFG.value_size) {
+        std::cerr << "SuiteBench runs sets only, not -V maps\n";
+        exit(1);
+    }
+    SuiteSpec spec;
+    if (!spec.load(argv[optind]))
+        exit(1);
+    if (Config::CFG.results == "")
+        Config::CFG.results = "suite.results";
+
+    uint64_t start = getElapsedTime();
+    uint32_t builds = 0;
+    const std::string exec = Config::CFG.exec;
+    for (const std::string& name : spec.sets) {
+        Config::CFG.bmname = name;
+        for (uint32_t m : spec.m) {
+            Config::CFG.elements = m;
+            SuiteSet* set = NULL;
+            for (uint32_t p : spec.p) {
+                Config::CFG.threads = p;
+                if (!set || per_thread(name)) {
+                    if (!(set = make_set(name)))
+                        exit(1);
+                    ++builds;
+                }
+                for (uint32_t R : spec.R) {
+                    Config::CFG.set_lookups(R);
+                    run_point(set, spec.trials, exec);
+                }
+            }
+        }
+    }
+    std::cout << "suite, points=" << spec.points()
+              << ", trials=" << spec.trials << ", builds=" << builds
+              << ", results=" << Config::CFG.results
+              << ", time=" << getElapsedTime() - start << std::endl;
+}
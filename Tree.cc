@@ -1,15 +1,20 @@
-#include <climits>
+#include <deque>
 #include "Tree.h"
+#include "image.h"
+#include "payload.h"
+#include "strkey.h"
+#include "verify.h"
 
 #define TM_WRITE(x,y) x = y
 
 // binary search for the node that has v as its value
-bool RBTree::lookup(int v) const
+template<class K, class V>
+bool RBMap<K,V>::lookup(const K& v) const
 {
     // find v
     RBNode* x = (sentinel->m_child[0]);
     while (x != NULL) {
-        long xval = (x->m_val);
+        const K& xval = (x->m_val);
         if (xval == v)
             return true;
         else
@@ -18,7 +23,31 @@ bool RBTree::lookup(int v) const
     return false;
 }
 
-void RBTree::modify(int v)
+// the one descent that every update shares: return the node holding v, or
+// NULL, in which case curr->m_child[cID] is the empty link where v belongs
+template<class K, class V>
+typename RBMap<K,V>::RBNode*
+RBMap<K,V>::find(const K& v, RBNode*& curr, int& cID) const
+{
+    curr = sentinel;
+    cID = 0;
+    RBNode* child((curr->m_child[cID]));
+
+    while (child != NULL) {
+        const K& cval = (child->m_val);
+        if (cval == v)
+            return child;
+        cID = v < cval ? 0 : 1;
+        curr = child;
+        child = (curr->m_child[cID]);
+    }
+    return NULL;
+}
+
+// the old read-modify-write: a lookup, and then a second descent to insert or
+// remove.  Kept as the baseline that toggle() is measured against
+template<class K, class V>
+void RBMap<K,V>::modify(const K& v)
 {
     if (lookup(v))
         remove(v);
@@ -27,34 +56,103 @@ void RBTree::modify(int v)
 }
 
 // insert a node with v as its value if no such node exists in the tree
-bool RBTree::insert(int v)
+template<class K, class V>
+bool RBMap<K,V>::insert(const K& v)
 {
-    // find insertion point
-    const RBNode* curr(sentinel);
-    int cID = 0;
-    RBNode* child((curr->m_child[cID]));
+    RBNode* curr;
+    int cID;
+    if (find(v, curr, cID))
+        return false; // don't add existing key
+    link(curr, cID, v, V());
+    return true;
+}
 
-    while (child != NULL) {
-        long cval = (child->m_val);
-        if (cval == v)
-            return false; // don't add existing key
-        cID = v < cval ? 0 : 1;
-        curr = child;
-        child = (curr->m_child[cID]);
+// remove the node with v as its value if it exists in the tree
+template<class K, class V>
+bool RBMap<K,V>::remove(const K& v)
+{
+    RBNode* curr;
+    int cID;
+    RBNode* x = find(v, curr, cID);
+    if (x == NULL)
+        return false;
+    unlink(x);
+    return true;
+}
+
+// remove v if it is in the tree, and insert it otherwise, in one descent
+template<class K, class V>
+bool RBMap<K,V>::toggle(const K& v)
+{
+    RBNode* curr;
+    int cID;
+    RBNode* x = find(v, curr, cID);
+    if (x != NULL) {
+        unlink(x);
+        return false;
     }
+    link(curr, cID, v, V());
+    return true;
+}
 
+// set v's data, inserting v if it is not in the tree
+template<class K, class V>
+bool RBMap<K,V>::insert_or_assign(const K& v, const V& data)
+{
+    RBNode* curr;
+    int cID;
+    RBNode* x = find(v, curr, cID);
+    if (x != NULL) {
+        TM_WRITE(x->m_data, data);
+        return false;
+    }
+    link(curr, cID, v, data);
+    return true;
+}
+
+// copy v's data out, if v is in the tree
+template<class K, class V>
+bool RBMap<K,V>::get(const K& v, V& data) const
+{
+    RBNode* curr;
+    int cID;
+    const RBNode* x = find(v, curr, cID);
+    if (x == NULL)
+        return false;
+    data = (x->m_data);
+    return true;
+}
+
+// overwrite v's data, if v is in the tree
+template<class K, class V>
+bool RBMap<K,V>::update(const K& v, const V& data)
+{
+    RBNode* curr;
+    int cID;
+    RBNode* x = find(v, curr, cID);
+    if (x == NULL)
+        return false;
+    TM_WRITE(x->m_data, data);
+    return true;
+}
+
+// attach a new node holding v and data as curr->m_child[cID], which must be
+// the empty link that find() returned, and rebalance
+template<class K, class V>
+void RBMap<K,V>::link(RBNode* curr, int cID, const K& v, const V& data)
+{
     // create the new node ("child") and attach it as curr->child[cID]
-    child = (RBNode*)malloc(sizeof(RBNode));
+    RBNode* child = (RBNode*)malloc(sizeof(RBNode));
     child->m_color = RED;
     child->m_val = v;
-    child->m_parent = const_cast<RBNode*>(curr);
+    child->m_parent = curr;
     child->m_ID = cID;
+    child->m_data = data;
     child->m_child[0] = NULL;
     child->m_child[1] = NULL;
 
-    RBNode* curr_rw = const_cast<RBNode*>(curr);
     const RBNode* child_r(child);
-    TM_WRITE(curr_rw->m_child[cID], child);
+    TM_WRITE(curr->m_child[cID], child);
 
     // balance the tree
     while (true) {
@@ -143,30 +241,13 @@ bool RBTree::insert(int v)
         RBNode* root_rw = const_cast<RBNode*>(root_r);
         TM_WRITE(root_rw->m_color, BLACK);
     }
-    return true;
 }
 
-// remove the node with v as its value if it exists in the tree
-bool RBTree::remove(int v)
-{
-    // find v
-    const RBNode* sentinel_r(sentinel);
-    // rename x_r to x_rw, x_rr to x_r
-    const RBNode* x_r((sentinel_r->m_child[0]));
-
-    while (x_r != NULL) {
-        int xval = (x_r->m_val);
-        if (xval == v)
-            break;
-        x_r = (x_r->m_child[v < xval ? 0 : 1]);
-    }
-
-    // if we found v, remove it.  Otherwise return
-    if (x_r == NULL)
-        return false;
-
-    RBNode* x_rw = const_cast<RBNode*>(x_r); // upgrade to writable
 
+// remove x from the tree and rebalance
+template<class K, class V>
+void RBMap<K,V>::unlink(RBNode* x_rw)
+{
     // ensure that we are deleting a node with at most one child
     // cache value of rhs child
     RBNode* xrchild((x_rw->m_child[1]));
@@ -179,6 +260,7 @@ bool RBTree::remove(int v)
             leftmost_r = (leftmost_r->m_child[0]);
 
         TM_WRITE(x_rw->m_val, (leftmost_r->m_val));
+        TM_WRITE(x_rw->m_data, (leftmost_r->m_data));
         x_rw = const_cast<RBNode*>(leftmost_r);
     }
 
@@ -364,64 +446,99 @@ bool RBTree::remove(int v)
 
     // free storage associated with deleted node
     free(x_rw);
-    return true;
 }
 
 
-// returns black-height when balanced and -1 otherwise
-int RBTree::blackHeight(const RBNode* x)
+
+
+// the whole sanity check, in one pass: returns the black height of the
+// subtree rooted at x, or -1 if x isn't p's xID'th child, a key isn't
+// strictly between the bounds (NULL means unbounded), a red node has a red
+// child, or the black heights of two siblings differ
+template<class K, class V>
+int RBMap<K,V>::check(const RBNode* p, int xID, const RBNode* x,
+                      const K* lowerBound, const K* upperBound)
 {
     if (!x)
         return 0;
-    const RBNode* x_r(x);
-    int bh0 = blackHeight(x_r->m_child[0]);
-    int bh1 = blackHeight(x_r->m_child[1]);
-    if ((bh0 >= 0) && (bh1 == bh0))
-        return BLACK==x_r->m_color ? 1+bh0 : bh0;
-    else
+    if ((x->m_parent != p) || (x->m_ID != xID)
+        || (lowerBound && !(*lowerBound < x->m_val))
+        || (upperBound && !(x->m_val < *upperBound))
+        || (RED == p->m_color && RED == x->m_color))
         return -1;
+    int bh0 = check(x, 0, x->m_child[0], lowerBound, &x->m_val);
+    if (bh0 < 0)
+        return -1;
+    int bh1 = check(x, 1, x->m_child[1], &x->m_val, upperBound);
+    if (bh1 != bh0)
+        return -1;
+    return BLACK == x->m_color ? 1 + bh0 : bh0;
 }
 
-// returns true when a red node has a red child
-bool RBTree::redViolation(const RBNode* p_r, const RBNode* x)
+// A subtree that the parallel check hands to one thread, and its result:
+// a black height, -1, or UNCHECKED if the sample left it out
+template<class K, class V>
+struct RBMap<K,V>::Subtree
 {
-    if (!x)
-        return false;
-    const RBNode* x_r(x);
-    return ((RED == p_r->m_color && RED == x_r->m_color)
-            || (redViolation(x_r, x_r->m_child[0]))
-            || (redViolation(x_r, x_r->m_child[1])));
-}
-
-// returns true when all nodes' parent fields point to their parents
-bool RBTree::validParents(const RBNode* p, int xID, const RBNode* x)
+    const RBNode* p;
+    int           xID;
+    const RBNode* x;
+    const K*      lowerBound;
+    const K*      upperBound;
+    int           bh;
+};
+
+// collect the subtrees depth levels below x, left to right
+template<class K, class V>
+void RBMap<K,V>::split(const RBNode* p, int xID, const RBNode* x,
+                       const K* lowerBound, const K* upperBound, int depth,
+                       std::vector<Subtree>& out)
 {
-    if (!x)
-        return true;
-    const RBNode* x_r(x);
-    return ((x_r->m_parent == p)
-            && (x_r->m_ID == xID)
-            && (validParents(x, 0, x_r->m_child[0]))
-            && (validParents(x, 1, x_r->m_child[1])));
+    if (depth == 0 || !x) {
+        out.push_back(Subtree{p, xID, x, lowerBound, upperBound, UNCHECKED});
+        return;
+    }
+    split(x, 0, x->m_child[0], lowerBound, &x->m_val, depth - 1, out);
+    split(x, 1, x->m_child[1], &x->m_val, upperBound, depth - 1, out);
 }
 
-// returns true when the tree is ordered
-bool RBTree::inOrder(const RBNode* x, int lowerBound, int upperBound)
+// check() for the part of the tree above the subtrees, taking their black
+// heights from the parallel pass, in the same left-to-right order
+template<class K, class V>
+int RBMap<K,V>::check_top(const RBNode* p, int xID, const RBNode* x,
+                          const K* lowerBound, const K* upperBound,
+                          int depth, const std::vector<Subtree>& subtrees,
+                          size_t& next)
 {
-    if (!x)
-        return true;
-    const RBNode* x_r(x);
-    return ((lowerBound <= x_r->m_val)
-            && (x_r->m_val <= upperBound)
-            && (inOrder(x_r->m_child[0], lowerBound, x_r->m_val - 1))
-            && (inOrder(x_r->m_child[1], x_r->m_val + 1, upperBound)));
+    if (depth == 0 || !x)
+        return subtrees[next++].bh;
+    if ((x->m_parent != p) || (x->m_ID != xID)
+        || (lowerBound && !(*lowerBound < x->m_val))
+        || (upperBound && !(x->m_val < *upperBound))
+        || (RED == p->m_color && RED == x->m_color))
+        return -1;
+    int bh0 = check_top(x, 0, x->m_child[0], lowerBound, &x->m_val,
+                        depth - 1, subtrees, next);
+    if (bh0 == -1)
+        return -1;
+    int bh1 = check_top(x, 1, x->m_child[1], &x->m_val, upperBound,
+                        depth - 1, subtrees, next);
+    if (bh1 == -1 || (bh0 >= 0 && bh1 >= 0 && bh0 != bh1))
+        return -1;
+    // an unchecked child can't be compared, but the other one can be
+    int bh = (bh0 >= 0) ? bh0 : bh1;
+    if (bh < 0)
+        return UNCHECKED;
+    return BLACK == x->m_color ? 1 + bh : bh;
 }
 
 // build an empty tree
-RBTree::RBTree() : sentinel(new RBNode()) { }
+template<class K, class V>
+RBMap<K,V>::RBMap() : sentinel(new RBNode()) { }
 
-// sanity check of the RBTree data structure
-bool RBTree::isSane() const
+// sanity check of the RBMap data structure
+template<class K, class V>
+bool RBMap<K,V>::isSane() const
 {
     const RBNode* sentinel_r(sentinel);
     RBNode* root = sentinel_r->m_child[0];
@@ -431,8 +548,91 @@ bool RBTree::isSane() const
 
     const RBNode* root_r(root);
     return ((BLACK == root_r->m_color) &&
-            (blackHeight(root) >= 0) &&
-            !(redViolation(sentinel_r, root)) &&
-            (validParents(sentinel, 0, root)) &&
-            (inOrder(root, INT_MIN, INT_MAX)));
+            (check(sentinel, 0, root, NULL, NULL) >= 0));
+}
+
+// the same check, with the subtrees a few levels down spread across threads
+// (about 8 per thread, so that uneven subtrees balance out), and with a
+// sample of N > 1, only about 1/N of them checked
+template<class K, class V>
+bool RBMap<K,V>::verify(uint32_t threads, uint32_t sample) const
+{
+    if (threads <= 1 && sample <= 1)
+        return isSane();
+
+    RBNode* root = sentinel->m_child[0];
+    if (!root)
+        return true;
+    if (BLACK != root->m_color)
+        return false;
+
+    int depth = 0;
+    while ((1u << depth) < 8 * threads && depth < 16)
+        ++depth;
+    std::vector<Subtree> subtrees;
+    split(sentinel, 0, root, NULL, NULL, depth, subtrees);
+    bool ok = verify_units(subtrees.size(), threads, sample, [&](uint32_t u) {
+        Subtree& s = subtrees[u];
+        s.bh = check(s.p, s.xID, s.x, s.lowerBound, s.upperBound);
+        return s.bh >= 0;
+    });
+    size_t next = 0;
+    return ok && (check_top(sentinel, 0, root, NULL, NULL, depth, subtrees,
+                            next) != -1);
+}
+
+// write the tree to an image, in breadth-first order, so that each node's
+// children get their numbers (and thus offsets) before the node is written
+template<class K, class V>
+bool RBMap<K,V>::save_image(const char* path, uint64_t elements) const
+{
+    image_writer w(path, "RBMap", sizeof(RBNode), elements);
+    if (!w.ok())
+        return false;
+    // each queued node carries its parent's number
+    std::deque<std::pair<const RBNode*, uint64_t> > q;
+    q.push_back(std::make_pair(sentinel, 0));
+    uint64_t me = 0, next = 1;
+    while (!q.empty()) {
+        const RBNode* x = q.front().first;
+        RBNode n(*x);
+        n.m_parent = (x == sentinel) ? NULL
+                   : image_offset<RBNode>(q.front().second);
+        q.pop_front();
+        for (int c = 0; c < 2; ++c) {
+            if (x->m_child[c]) {
+                n.m_child[c] = image_offset<RBNode>(next++);
+                q.push_back(std::make_pair(x->m_child[c], me));
+            }
+        }
+        w.put(&n);
+        ++me;
+    }
+    return w.finish();
+}
+
+// map an image and relocate its pointers; the sentinel is node 0
+template<class K, class V>
+bool RBMap<K,V>::load_image(const char* path, uint64_t elements)
+{
+    uint64_t n;
+    char* base = image_map(path, "RBMap", sizeof(RBNode), elements, n);
+    if (!base)
+        return false;
+    RBNode* nodes = (RBNode*)(base + sizeof(ImageHeader));
+    for (uint64_t i = 0; i < n; ++i) {
+        image_relocate(base, nodes[i].m_parent);
+        image_relocate(base, nodes[i].m_child[0]);
+        image_relocate(base, nodes[i].m_child[1]);
+    }
+    delete sentinel;
+    sentinel = nodes;
+    return true;
 }
+
+// the maps the benchmarks use
+template class RBMap<int, NoValue>;
+template class RBMap<int, int>;
+#define RBMAP_PAYLOAD(N) template class RBMap<int, Payload<N> >;
+PAYLOAD_SIZES(RBMAP_PAYLOAD)
+template class RBMap<StrKey, int>;
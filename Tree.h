@@ -13,28 +13,40 @@
 #pragma once
 
 #include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include "novalue.h"
 
-class RBTree
+// Red-black tree map from K to V.  Keys need only < and ==; RBTree, the
+// IntSet the benchmarks use, is an RBMap<int, NoValue>.  Tree.cc
+// instantiates the maps we use: no values, int values, and each Payload
+// size (see payload.h).
+template<class K, class V>
+class RBMap
 {
     enum Color { RED, BLACK };
 
-    // Node of an RBTree
+    // Node of an RBMap.  The fields a descent reads come first, so that a
+    // large m_data doesn't push them onto another cache line.
     struct RBNode
     {
         Color   m_color;
-        int     m_val;
+        K       m_val;
         RBNode* m_parent;
-        int     m_ID;
         RBNode* m_child[2];
+        int     m_ID;
+        [[no_unique_address]]
+        V       m_data;     // the value mapped to m_val
 
         // basic constructor
         RBNode(Color color = BLACK,
-               long val = -1,
+               const K& val = K(),
                RBNode* parent = NULL,
                long ID = 0,
                RBNode* child0 = NULL,
                RBNode* child1 = NULL)
-            : m_color(color), m_val(val), m_parent(parent), m_ID(ID)
+            : m_color(color), m_val(val), m_parent(parent), m_ID(ID),
+              m_data()
         {
             m_child[0] = child0;
             m_child[1] = child1;
@@ -42,28 +54,106 @@ class RBTree
     };
 
     // helper functions for sanity checks
-    static int blackHeight(const RBNode* x);
-    static bool redViolation(const RBNode* p_r, const RBNode* x);
-    static bool validParents(const RBNode* p, int xID, const RBNode* x);
-    static bool inOrder(const RBNode* x, int lowerBound, int upperBound);
+    static int check(const RBNode* p, int xID, const RBNode* x,
+                     const K* lowerBound, const K* upperBound);
+
+    // ... and for the parallel one, which checks subtrees separately, and
+    // then the top of the tree using their results
+    struct Subtree;
+    static const int UNCHECKED = -2;
+    static void split(const RBNode* p, int xID, const RBNode* x,
+                      const K* lowerBound, const K* upperBound, int depth,
+                      std::vector<Subtree>& out);
+    static int check_top(const RBNode* p, int xID, const RBNode* x,
+                         const K* lowerBound, const K* upperBound, int depth,
+                         const std::vector<Subtree>& subtrees, size_t& next);
+
+    // every update is one call to find(), and then link() or unlink() on
+    // what it found, so no operation descends the tree twice
+
+    // the node holding val, or NULL and the empty link where val belongs
+    __attribute__((transaction_safe))
+    RBNode* find(const K& val, RBNode*& curr, int& cID) const;
+
+    // attach a new node for val at curr->m_child[cID], and rebalance
+    __attribute__((transaction_safe))
+    void link(RBNode* curr, int cID, const K& val, const V& data);
+
+    // remove x from the tree, rebalance, and free it
+    __attribute__((transaction_safe))
+    void unlink(RBNode* x);
 
   public:
     RBNode* sentinel;
 
-    RBTree();
+    RBMap();
 
     // standard IntSet methods
 
     __attribute__((transaction_safe))
-    bool lookup(int val) const;
+    bool lookup(const K& val) const;
+
+    __attribute__((transaction_safe))
+    bool insert(const K& val);
+
+    __attribute__((transaction_safe))
+    bool remove(const K& val);
 
+    // lookup, then insert or remove: two descents
     __attribute__((transaction_safe))
-    bool insert(int val);
+    void modify(const K& val);
 
+    // map methods.  Values are copied in and out, so with a large V the
+    // copy is most of what a transaction reads or writes.
+
+    // copy val's data out to data; false if val is not present
+    __attribute__((transaction_safe))
+    bool get(const K& val, V& data) const;
+
+    // "put": set val's data, inserting val if needed; true iff inserted
+    __attribute__((transaction_safe))
+    bool insert_or_assign(const K& val, const V& data);
+
+    // set val's data only if val is present; true iff it was
+    __attribute__((transaction_safe))
+    bool update(const K& val, const V& data);
+
+    // single-descent read-modify-write operations.  Inserted nodes start
+    // with a value-initialized V.
+
+    // remove val if present, else insert it; true iff val is now present
     __attribute__((transaction_safe))
-    bool remove(int val);
+    bool toggle(const K& val);
 
-    void modify(int val);
+    // add delta to val's data, inserting val if needed; returns the result.
+    // A template, so that maps whose V has no + can still be instantiated
+    template<class D>
+    __attribute__((transaction_safe))
+    V compute(const K& val, const D& delta)
+    {
+        RBNode* curr;
+        int cID;
+        RBNode* x = find(val, curr, cID);
+        if (x != NULL) {
+            x->m_data = x->m_data + delta;
+            return x->m_data;
+        }
+        V data = V() + delta;
+        link(curr, cID, val, data);
+        return data;
+    }
 
     bool isSane() const;
+
+    // isSane() on up to threads threads, and with a sample of N > 1, on
+    // only about 1/N of the tree below the top few levels; see verify.h
+    bool verify(uint32_t threads, uint32_t sample) const;
+
+    // write the tree to an image file, or replace this (empty) tree with
+    // the one in an image file; see image.h
+    bool save_image(const char* path, uint64_t elements) const;
+    bool load_image(const char* path, uint64_t elements);
 };
+
+// the integer set that the benchmarks use
+typedef RBMap<int, NoValue> RBTree;
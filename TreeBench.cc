@@ -11,9 +11,7 @@
 #include "bmconfig.h"
 #include "bmharness.h"
 #include "Tree.h"
-
-/// This is the tree we will manipulate in this experiment
-benchmark<RBTree> SET;
+#include "payload.h"
 
 /// This static, declared in bmconfig, needs to be defined
 Config Config::CFG;
@@ -29,17 +27,40 @@ void reparse_args() {
     else if (Config::CFG.bmname == "RBTree1M")  Config::CFG.elements = 1048576;
 }
 
-/// We just call to SET functions in main
-int main(int argc, char** argv) {
-    // parse command line
-    Config::CFG.parseargs(argc, argv, "TreeBench");
-    reparse_args();
+/// Build, warm up, and test a tree of type T
+template<class T>
+void run_tree()
+{
+    // This is the tree we will manipulate in this experiment
+    benchmark<T> SET;
 
     // warm up the data structure
     SET.warmup();
 
     // run the tests
     SET.launch_test();
+}
+
+/// With -V, the tree is a map to values of that many bytes
+struct run_map
+{
+    template<class V>
+    void run() { run_tree<PayloadSet<RBMap<int, V>, V> >(); }
+};
+
+/// We just call to SET functions in main
+int main(int argc, char** argv) {
+    // parse command line
+    Config::CFG.parseargs(argc, argv, "TreeBench");
+    reparse_args();
+
+    if (!Config::CFG.value_size)
+        run_tree<RBTree>();
+    else if (!with_payload(Config::CFG.value_size, run_map())) {
+        std::cerr << "Unsupported value size " << Config::CFG.value_size
+                  << "\n";
+        exit(1);
+    }
 
     // print results
     Config::CFG.dump_csv();
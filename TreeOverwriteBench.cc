@@ -0,0 +1,117 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#include <cstring>
+#include "bmconfig.h"
+#include "bmharness.h"
+#include "Tree.h"
+
+/// Upsert and Compute store values, so this is a map of ints rather than
+/// the RBTree set
+typedef RBMap<int, int> IntTree;
+
+/// This is the tree we will manipulate in this experiment
+benchmark<IntTree>* SET;
+
+/// This static, declared in bmconfig, needs to be defined
+Config Config::CFG;
+
+/// Every workload is one read-modify-write of a random key per transaction,
+/// against a tree that starts half full.  Modify is the two-descent baseline
+/// (lookup, then insert or remove); the others descend once.
+
+/// Modify: lookup, then insert or remove
+static bool modify_op(IntTree* tree, uint32_t, uint32_t* seed)
+{
+    int val = rand_r_32(seed) % Config::CFG.elements;
+    __transaction_atomic {
+        tree->modify(val);
+    }
+    return true;
+}
+
+/// Toggle: the same change as Modify, in one descent
+static bool toggle_op(IntTree* tree, uint32_t, uint32_t* seed)
+{
+    int val = rand_r_32(seed) % Config::CFG.elements;
+    bool inserted;
+    __transaction_atomic {
+        inserted = tree->toggle(val);
+    }
+    return inserted;
+}
+
+/// Upsert: overwrite a key's data, inserting the key if it is missing
+static bool upsert_op(IntTree* tree, uint32_t id, uint32_t* seed)
+{
+    int val = rand_r_32(seed) % Config::CFG.elements;
+    bool inserted;
+    __transaction_atomic {
+        inserted = tree->insert_or_assign(val, id);
+    }
+    return inserted;
+}
+
+/// Compute: increment a key's data, inserting the key if it is missing
+static bool compute_op(IntTree* tree, uint32_t, uint32_t* seed)
+{
+    int val = rand_r_32(seed) % Config::CFG.elements;
+    __transaction_atomic {
+        tree->compute(val, 1);
+    }
+    return true;
+}
+
+/// Names are a workload and an optional size: Toggle, Toggle1K, Upsert64K...
+void reparse_args()
+{
+    if (Config::CFG.bmname == "") Config::CFG.bmname = "Toggle";
+
+    static const char* ops[] = { "Modify", "Toggle", "Upsert", "Compute" };
+    static benchmark<IntTree>::iteration_op fns[] =
+        { modify_op, toggle_op, upsert_op, compute_op };
+
+    std::string name = Config::CFG.bmname;
+    int op = -1;
+    for (int i = 0; i < 4; ++i)
+        if (name.compare(0, strlen(ops[i]), ops[i]) == 0)
+            op = i;
+    std::string size = (op < 0) ? "" : name.substr(strlen(ops[op]));
+    if      (size == "")    ;
+    else if (size == "16")  Config::CFG.elements = 16;
+    else if (size == "256") Config::CFG.elements = 256;
+    else if (size == "1K")  Config::CFG.elements = 1024;
+    else if (size == "64K") Config::CFG.elements = 65536;
+    else if (size == "1M")  Config::CFG.elements = 1048576;
+    else op = -1;
+    if (op < 0) {
+        std::cerr << "Unknown workload " << name << "\n";
+        exit(1);
+    }
+
+    SET = new benchmark<IntTree>(new IntTree());
+    SET->set_op(fns[op]);
+}
+
+/// We just call to SET functions in main
+int main(int argc, char** argv) {
+    // parse command line
+    Config::CFG.parseargs(argc, argv, "TreeOverwriteBench");
+    reparse_args();
+
+    // warm up the data structure
+    SET->warmup();
+
+    // run the tests
+    SET->launch_test();
+
+    // print results
+    Config::CFG.dump_csv();
+}
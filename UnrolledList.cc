@@ -0,0 +1,179 @@
+#include <climits>
+#include <cstring>
+#include "UnrolledList.h"
+
+// vector of four keys, for comparing a whole node against a key at once
+typedef int v4si __attribute__((vector_size(16)));
+
+// NB: keys are moved with explicit memmove/memcpy, which the TM pass turns
+//     into _ITM_memmove and friends.  Written as loops, GCC may turn them
+//     into plain library calls inside the transactional clone, which are not
+//     logged and leave garbage behind when a transaction aborts.
+
+// constructor: an empty list has no nodes at all
+UnrolledList::UnrolledList() : head(NULL) { }
+
+// count the keys less than val.  Unused slots are INT_MAX, so they never
+// count, and we don't need to look at m_count
+int UnrolledList::rank(const Node* n, int val)
+{
+    v4si v = {val, val, val, val};
+    const v4si* k = (const v4si*)n->m_keys;
+    v4si lt = (k[0] < v) + (k[1] < v) + (k[2] < v);
+    return -(lt[0] + lt[1] + lt[2] + lt[3]);
+}
+
+// allocate a node with no keys, on a cache line of its own.  There is no
+// transactional posix_memalign, so take a line more than we need from
+// malloc, round up, and keep malloc's pointer just before the node
+UnrolledList::Node* UnrolledList::new_node(Node* next)
+{
+    char* raw = (char*)malloc(sizeof(Node) + 64);
+    Node* n = (Node*)(((uintptr_t)raw + sizeof(void*) + 63) & ~(uintptr_t)63);
+    ((void**)n)[-1] = raw;
+    for (int i = 0; i < K; ++i)
+        n->m_keys[i] = INT_MAX;
+    n->m_count = 0;
+    n->m_next = next;
+    return n;
+}
+
+// free a node from new_node
+void UnrolledList::free_node(Node* n)
+{
+    free(((void**)n)[-1]);
+}
+
+// simple sanity check: every node has between 1 and K keys, unused slots
+// are INT_MAX, and all keys are in sorted order
+bool UnrolledList::isSane(void) const
+{
+    bool first = true;
+    int last = 0;
+    for (const Node* n = head; n != NULL; n = n->m_next) {
+        if (n->m_count < 1 || n->m_count > K)
+            return false;
+        for (int i = 0; i < K; ++i) {
+            if (i >= n->m_count) {
+                if (n->m_keys[i] != INT_MAX)
+                    return false;
+                continue;
+            }
+            if (!first && n->m_keys[i] <= last)
+                return false;
+            first = false;
+            last = n->m_keys[i];
+        }
+    }
+    return true;
+}
+
+// search function
+bool UnrolledList::lookup(int val) const
+{
+    const Node* n = head;
+    if (n == NULL)
+        return false;
+    // find the first node whose largest key is >= val
+    while (n->m_next != NULL && n->m_keys[n->m_count - 1] < val)
+        n = n->m_next;
+    int r = rank(n, val);
+    return (r < n->m_count) && (n->m_keys[r] == val);
+}
+
+// insert method; find the node that should hold val, splitting it if it is
+// full; if val is already in the list, exit without inserting
+bool UnrolledList::insert(int val)
+{
+    if (head == NULL)
+        head = new_node(NULL);
+
+    // find the first node whose largest key is >= val, or the last node
+    Node* n = head;
+    while (n->m_next != NULL && n->m_keys[n->m_count - 1] < val)
+        n = n->m_next;
+
+    int r = rank(n, val);
+    if ((r < n->m_count) && (n->m_keys[r] == val))
+        return false;
+
+    // full?  move the upper half of the keys into a new successor
+    if (n->m_count == K) {
+        Node* m = new_node(n->m_next);
+        memcpy(m->m_keys, &n->m_keys[K/2], (K - K/2) * sizeof(int));
+        for (int i = K/2; i < K; ++i)
+            n->m_keys[i] = INT_MAX;
+        m->m_count = K - K/2;
+        n->m_count = K/2;
+        n->m_next = m;
+        if (r > K/2) {
+            n = m;
+            r -= K/2;
+        }
+    }
+
+    // shift the larger keys up, and put val in the gap
+    memmove(&n->m_keys[r + 1], &n->m_keys[r], (n->m_count - r) * sizeof(int));
+    n->m_keys[r] = val;
+    n->m_count++;
+    return true;
+}
+
+// remove val if present; empty nodes are unlinked, and a node that falls
+// below K/4 keys absorbs its successor if the two fit in one node
+bool UnrolledList::remove(int val)
+{
+    Node* prev = NULL;
+    Node* n = head;
+    if (n == NULL)
+        return false;
+    while (n->m_next != NULL && n->m_keys[n->m_count - 1] < val) {
+        prev = n;
+        n = n->m_next;
+    }
+
+    int r = rank(n, val);
+    if ((r == n->m_count) || (n->m_keys[r] != val))
+        return false;
+
+    // shift the larger keys down over val
+    int count = n->m_count - 1;
+    memmove(&n->m_keys[r], &n->m_keys[r + 1], (count - r) * sizeof(int));
+    n->m_keys[count] = INT_MAX;
+    n->m_count = count;
+
+    Node* next = n->m_next;
+    if (count == 0) {
+        if (prev != NULL)
+            prev->m_next = next;
+        else
+            head = next;
+        free_node(n);
+    }
+    else if ((count < K/4) && (next != NULL) && (count + next->m_count <= K)) {
+        int nc = next->m_count;
+        memcpy(&n->m_keys[count], next->m_keys, nc * sizeof(int));
+        n->m_count = count + nc;
+        n->m_next = next->m_next;
+        free_node(next);
+    }
+    return true;
+}
+
+// findmax function
+int UnrolledList::findmax() const
+{
+    const Node* n = head;
+    if (n == NULL)
+        return -1;
+    while (n->m_next != NULL)
+        n = n->m_next;
+    return n->m_keys[n->m_count - 1];
+}
+
+// findmin function
+int UnrolledList::findmin() const
+{
+    const Node* n = head;
+    return (n == NULL) ? -1 : n->m_keys[0];
+}
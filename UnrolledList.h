@@ -0,0 +1,75 @@
+// -*-c++-*-
+
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+
+// Sorted set as an unrolled linked list: each node holds up to K sorted keys
+// and fills one cache line, so a traversal takes roughly K times fewer
+// misses (and transactional reads) than List.  Unused key slots hold
+// INT_MAX, which lets the in-node search compare all K slots with vector
+// compares and no masking.
+class UnrolledList
+{
+    // keys per node; a multiple of 4 so the keys are whole vectors
+    static const int K = 12;
+
+    // Node in an UnrolledList
+    struct Node
+    {
+        int   m_keys[K] __attribute__((aligned(16)));
+        int   m_count;
+        Node* m_next;
+    } __attribute__((aligned(64)));
+
+    Node* head;
+
+    // number of keys in n that are less than val
+    __attribute__((transaction_safe))
+    static int rank(const Node* n, int val);
+
+    // make a node holding no keys
+    __attribute__((transaction_safe))
+    static Node* new_node(Node* next);
+
+    // free a node made by new_node
+    __attribute__((transaction_safe))
+    static void free_node(Node* n);
+
+  public:
+
+    UnrolledList();
+
+    // true iff val is in the data structure
+    __attribute__((transaction_safe))
+    bool lookup(int val) const;
+
+    // standard IntSet methods
+    __attribute__((transaction_safe))
+    bool insert(int val);
+
+    // remove val if it is present
+    __attribute__((transaction_safe))
+    bool remove(int val);
+
+    // make sure the keys are in sorted order and the nodes are well formed
+    bool isSane() const;
+
+    // find max and min
+    __attribute__((transaction_safe))
+    int findmax() const;
+
+    __attribute__((transaction_safe))
+    int findmin() const;
+};
@@ -0,0 +1,101 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#include "bmconfig.h"
+#include "bmharness.h"
+#include "DList.h"
+
+/// The increments don't keep the keys in order, so only check the links
+struct DListWorkload : public DList
+{
+    bool isSane() const { return isLinked(); }
+};
+
+/// This is the list we will manipulate in this experiment
+benchmark<DListWorkload>* SET;
+
+/// This static, declared in bmconfig, needs to be defined
+Config Config::CFG;
+
+/// WWPathology: odd threads increment the whole list front to back, even
+/// threads back to front, so every pair of transactions conflicts
+static bool increment_ends(DListWorkload* list, uint32_t id, uint32_t*)
+{
+    __transaction_atomic {
+        // need to look at the timer, or we'll livelock!
+        if (Config::still_running()) {
+            if (id % 2)
+                list->increment_forward();
+            else
+                list->increment_backward();
+        }
+    }
+    return true;
+}
+
+/// WWPattern: each thread increments every pth element (p threads),
+/// starting at its id, from alternating ends; writes are disjoint, but
+/// every transaction reads what the others write
+static bool increment_pattern(DListWorkload* list, uint32_t id, uint32_t*)
+{
+    int seq = Config::CFG.threads;
+    __transaction_atomic {
+        if (Config::still_running()) {
+            if (id % 2)
+                list->increment_forward_pattern(id, seq);
+            else
+                list->increment_backward_pattern(id, seq);
+        }
+    }
+    return true;
+}
+
+/// WWChunk: each thread reads the whole list, then increments its own chunk
+static bool increment_chunk(DListWorkload* list, uint32_t id, uint32_t*)
+{
+    int chunk = Config::CFG.elements / Config::CFG.threads;
+    __transaction_atomic {
+        if (Config::still_running())
+            list->increment_chunk(id, chunk);
+    }
+    return true;
+}
+
+/// Pick the workload, and fill the list with 0 .. elements - 1
+void reparse_args()
+{
+    if (Config::CFG.bmname == "") Config::CFG.bmname = "WWPathology";
+
+    DListWorkload* list = new DListWorkload();
+    for (uint32_t i = 0; i < Config::CFG.elements; i++)
+        list->insert(i);
+    SET = new benchmark<DListWorkload>(list);
+
+    if      (Config::CFG.bmname == "WWPathology") SET->set_op(increment_ends);
+    else if (Config::CFG.bmname == "WWPattern")   SET->set_op(increment_pattern);
+    else if (Config::CFG.bmname == "WWChunk")     SET->set_op(increment_chunk);
+    else {
+        std::cerr << "Unknown workload " << Config::CFG.bmname << "\n";
+        exit(1);
+    }
+}
+
+/// We just call to SET functions in main
+int main(int argc, char** argv) {
+    // parse command line
+    Config::CFG.parseargs(argc, argv, "WWPathologyBench");
+    reparse_args();
+
+    // run the tests
+    SET->launch_test();
+
+    // print results
+    Config::CFG.dump_csv();
+}
@@ -0,0 +1,184 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <vector>
+#include "timing.h"
+
+/**
+ * Admission control (-a): at most 'limit' threads run transactions at once,
+ * the rest wait their turn.  The semaphore is a row of tokens, one per cache
+ * line; a thread starts looking at its own (id % limit), so while there is
+ * no waiting, each thread keeps reusing a token that no one else touches.
+ * When the limit is at least the thread count, acquire doesn't touch a
+ * token at all.  Lowering the limit doesn't evict anyone: threads holding
+ * tokens past the new limit finish their transaction first.
+ *
+ * With a fixed limit this is just a throttle.  With -a auto, a controller
+ * thread samples commit throughput every EPOCH_MS, and hill-climbs: it
+ * starts at the thread count, keeps moving the limit the same way (down,
+ * at first) while throughput improves, and turns around when it drops.
+ */
+class Admission
+{
+    static const uint32_t EPOCH_MS = 10;
+
+    /// a token, or a thread's commit count, on its own line
+    struct Padded
+    {
+        std::atomic<uint64_t> val;
+        char pad[64 - sizeof(std::atomic<uint64_t>)];
+    } __attribute__((aligned(64)));
+
+    uint32_t              threads;
+    bool                  adaptive;
+    std::atomic<uint32_t> limit;
+    Padded*               tokens;
+    Padded*               commits;
+
+    std::thread           controller;
+    std::atomic<bool>     stop;
+    std::vector<uint32_t> limits;       /// the limit in each epoch
+    std::vector<double>   tputs;        /// and the commits/s it got
+
+    /// a row of n Padded, each on its own line
+    static Padded* make_row(uint32_t n) {
+        void* p;
+        if (posix_memalign(&p, 64, n * sizeof(Padded)) != 0) {
+            std::cerr << "Could not allocate admission tokens\n";
+            exit(1);
+        }
+        Padded* row = static_cast<Padded*>(p);
+        for (uint32_t i = 0; i < n; ++i)
+            row[i].val = 0;
+        return row;
+    }
+
+    uint64_t total_commits() const {
+        uint64_t c = 0;
+        for (uint32_t i = 0; i < threads; ++i)
+            c += commits[i].val.load(std::memory_order_relaxed);
+        return c;
+    }
+
+    void control() {
+        uint64_t last_time = getElapsedTime(), last_commits = 0;
+        double last_tput = 0;
+        int dir = -1;
+        while (!stop) {
+            sleep_ms(EPOCH_MS);
+            uint64_t now = getElapsedTime(), c = total_commits();
+            double tput = 1e9 * (c - last_commits) / (now - last_time);
+            uint32_t l = limit;
+            limits.push_back(l);
+            tputs.push_back(tput);
+            if (adaptive) {
+                if (tput < last_tput)
+                    dir = -dir;
+                if ((dir < 0 && l == 1) || (dir > 0 && l == threads))
+                    dir = -dir;
+                limit = std::max(1u, std::min(threads, l + dir));
+            }
+            last_time = now;
+            last_commits = c;
+            last_tput = tput;
+        }
+    }
+
+  public:
+
+    /// fixed == 0 means adapt, starting from threads
+    Admission(uint32_t _threads, uint32_t fixed)
+        : threads(_threads), adaptive(!fixed),
+          limit(fixed ? std::min(fixed, _threads) : _threads),
+          tokens(make_row(_threads)), commits(make_row(_threads)),
+          stop(false)
+    {
+        controller = std::thread([this] { control(); });
+    }
+
+    ~Admission() {
+        finish();
+        free(tokens);
+        free(commits);
+    }
+
+    /// stop the controller, at the end of the run
+    void finish() {
+        stop = true;
+        if (controller.joinable())
+            controller.join();
+    }
+
+    /// wait for a token; returns it, or -1 if none was needed
+    int acquire(uint32_t id) {
+        for (uint32_t k = 0; ; ++k) {
+            uint32_t l = limit.load(std::memory_order_relaxed);
+            if (l >= threads)
+                return -1;
+            uint32_t t = (id + k) % l;
+            uint64_t free = 0;
+            if (tokens[t].val.load(std::memory_order_relaxed) == 0 &&
+                tokens[t].val.compare_exchange_strong(free, 1))
+                return t;
+            // tried every token: let a holder run
+            if (k % l == l - 1)
+                yield_cpu();
+        }
+    }
+
+    /// give back the token from acquire, and count a commit
+    void release(uint32_t id, int token) {
+        if (token >= 0)
+            tokens[token].val.store(0, std::memory_order_release);
+        commits[id].val.store(commits[id].val.load(std::memory_order_relaxed)
+                              + 1, std::memory_order_relaxed);
+    }
+
+    /// The limit over time, one entry per epoch, and the limit whose epochs
+    /// had the best mean throughput
+    void report() const {
+        std::map<uint32_t, std::pair<double, uint32_t> > by_limit;
+        double sum = 0;
+        for (size_t i = 0; i < limits.size(); ++i) {
+            by_limit[limits[i]].first += tputs[i];
+            by_limit[limits[i]].second++;
+            sum += limits[i];
+        }
+        uint32_t best = limit;
+        double best_tput = 0;
+        for (auto& b : by_limit) {
+            double mean = b.second.first / b.second.second;
+            if (mean > best_tput) {
+                best = b.first;
+                best_tput = mean;
+            }
+        }
+        std::cout << "admission, mode=" << (adaptive ? "auto" : "fixed")
+                  << ", epoch_ms=" << EPOCH_MS
+                  << ", epochs=" << limits.size()
+                  << ", final_limit=" << limit
+                  << ", mean_limit=" << (limits.empty() ? 0
+                                         : sum / limits.size())
+                  << ", best_limit=" << best
+                  << ", best_tput=" << best_tput << ", limits=";
+        for (size_t i = 0; i < limits.size(); ++i)
+            std::cout << (i ? "/" : "") << limits[i];
+        std::cout << std::endl;
+    }
+};
@@ -0,0 +1,462 @@
+#include <malloc.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <atomic>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "alloc.h"
+#include "hugemem.h"
+
+// glibc's real allocator entry points
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void  __libc_free(void*);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+}
+
+// A thread's counters, on a line of their own: every malloc and free writes
+// them.  The live bytes are kept globally, but a thread only adds its change
+// to them once that has grown past LIVE_BATCH either way, so the global line
+// is written every few thousand small blocks rather than on every one.
+struct Slot
+{
+    AllocStats stats;
+    int64_t    pending;
+} __attribute__((aligned(64)));
+
+static const int64_t LIVE_BATCH = 64 << 10;
+
+// counters for up to MAX_SLOTS live threads; a thread's slot is given back
+// when it exits, and its counters stay in the totals.  Threads beyond that
+// share the overflow slot, which is updated atomically.
+static const int MAX_SLOTS = 4096;
+static Slot slots[MAX_SLOTS];
+static Slot overflow;
+static std::atomic<int> nslots(0);
+static int free_slots[MAX_SLOTS];
+static int nfree = 0;
+static std::atomic_flag slot_lock = ATOMIC_FLAG_INIT;
+static pthread_key_t slot_key;
+static pthread_once_t slot_once = PTHREAD_ONCE_INIT;
+
+// the live bytes, as of each thread's last flush, and the most they have been
+static std::atomic<int64_t> live __attribute__((aligned(64)));
+static std::atomic<int64_t> peak __attribute__((aligned(64)));
+
+// no constructor, so this is safe to touch from inside malloc
+static thread_local Slot* my_slot;
+
+// regions whose blocks free() must leave alone
+static const int MAX_FOREIGN = 64;
+static uintptr_t foreign_lo[MAX_FOREIGN];
+static uintptr_t foreign_hi[MAX_FOREIGN];
+static std::atomic<int> nforeign(0);
+
+static bool enabled = false;
+
+// Small-block pools on 2MB pages.  One range of address space is reserved
+// up front, and handed out a 2MB chunk at a time, each chunk mapped with
+// MAP_HUGETLB if it can be and as an ordinary mapping advised for THP if
+// not.  A chunk belongs to one thread and one size class, so a pool block
+// needs no header: its size comes from its chunk, and free() knows a pool
+// block by its address.  Freed blocks go on the freeing thread's list.
+static const size_t POOL_GRAIN   = 16;
+static const size_t POOL_MAX     = 2048;
+static const int    POOL_CLASSES = POOL_MAX / POOL_GRAIN;
+static const size_t POOL_RESERVE =
+    (sizeof(void*) == 8) ? (size_t)64 << 30 : (size_t)512 << 20;
+static const size_t POOL_CHUNKS  = POOL_RESERVE / HUGE_PAGE;
+
+static bool pooling = false;
+static uintptr_t pool_lo, pool_hi;
+static std::atomic<size_t> pool_next(0);
+static std::atomic<uint64_t> pool_got[3];       // chunks, by HugeMode
+static uint8_t chunk_class[POOL_CHUNKS];
+
+// bump pointers and free lists; no constructor, like my_slot
+struct PoolThread
+{
+    char* next[POOL_CLASSES];
+    char* end[POOL_CLASSES];
+    void* free[POOL_CLASSES];
+};
+static thread_local PoolThread pool_my;
+
+static bool in_pool(void* p)
+{
+    return (uintptr_t)p - pool_lo < pool_hi - pool_lo;
+}
+
+static size_t pool_size(void* p)
+{
+    return (chunk_class[((uintptr_t)p - pool_lo) / HUGE_PAGE] + 1) * POOL_GRAIN;
+}
+
+// map the next chunk of the reserved range for size class c
+static char* pool_chunk(int c)
+{
+    size_t i = pool_next++;
+    if (i >= POOL_CHUNKS)
+        return NULL;
+    char* p = (char*)pool_lo + i * HUGE_PAGE;
+    HugeMode got = HUGE_TLB;
+    if (mmap(p, HUGE_PAGE, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB,
+             -1, 0) == MAP_FAILED)
+    {
+        if (mmap(p, HUGE_PAGE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == MAP_FAILED)
+            return NULL;
+        got = (madvise(p, HUGE_PAGE, MADV_HUGEPAGE) == 0) ? HUGE_THP : HUGE_NONE;
+    }
+    chunk_class[i] = c;
+    pool_got[got]++;
+    return p;
+}
+
+// a block of at least n <= POOL_MAX bytes, or NULL if the range is used up
+static void* pool_alloc(size_t n)
+{
+    int c = n ? (n - 1) / POOL_GRAIN : 0;
+    PoolThread& t = pool_my;
+    void* p = t.free[c];
+    if (p) {
+        t.free[c] = *(void**)p;
+        return p;
+    }
+    size_t sz = (c + 1) * POOL_GRAIN;
+    if ((size_t)(t.end[c] - t.next[c]) < sz) {
+        char* chunk = pool_chunk(c);
+        if (!chunk)
+            return NULL;
+        t.next[c] = chunk;
+        t.end[c] = chunk + HUGE_PAGE;
+    }
+    p = t.next[c];
+    t.next[c] += sz;
+    return p;
+}
+
+static void pool_free(void* p)
+{
+    int c = chunk_class[((uintptr_t)p - pool_lo) / HUGE_PAGE];
+    *(void**)p = pool_my.free[c];
+    pool_my.free[c] = p;
+}
+
+// the bytes a block really has
+static size_t block_size(void* p)
+{
+    return in_pool(p) ? pool_size(p) : malloc_usable_size(p);
+}
+
+// add a thread's pending change to the live bytes, and raise the peak
+static void flush_live(int64_t d)
+{
+    int64_t l = live.fetch_add(d) + d;
+    int64_t pk = peak.load();
+    while (l > pk && !peak.compare_exchange_weak(pk, l))
+        ;
+}
+
+// give an exiting thread's slot back
+static void release_slot(void* p)
+{
+    Slot* s = (Slot*)p;
+    flush_live(s->pending);
+    s->pending = 0;
+    while (slot_lock.test_and_set(std::memory_order_acquire))
+        ;
+    free_slots[nfree++] = s - slots;
+    slot_lock.clear(std::memory_order_release);
+    // later destructors may still free blocks; don't claim a slot for them
+    my_slot = &overflow;
+}
+
+static void make_slot_key() { pthread_key_create(&slot_key, release_slot); }
+
+// find (or claim) this thread's counters
+static Slot* slot()
+{
+    if (!my_slot) {
+        pthread_once(&slot_once, make_slot_key);
+        int i = -1;
+        while (slot_lock.test_and_set(std::memory_order_acquire))
+            ;
+        // a fresh slot first, so an exited thread's counters stay readable
+        // for as long as they can
+        if (nslots.load() < MAX_SLOTS)
+            i = nslots++;
+        else if (nfree)
+            i = free_slots[--nfree];
+        slot_lock.clear(std::memory_order_release);
+        if (i < 0)
+            return my_slot = &overflow;
+        my_slot = &slots[i];
+        my_slot->stats.id = -1;
+        pthread_setspecific(slot_key, my_slot);
+    }
+    return my_slot;
+}
+
+// bump a counter; the overflow slot's are shared
+static void bump(Slot* s, uint64_t& c, uint64_t n)
+{
+    if (s == &overflow)
+        __atomic_fetch_add(&c, n, __ATOMIC_RELAXED);
+    else
+        c += n;
+}
+
+// add n to the live bytes, a batch at a time
+static void note_live(Slot* s, int64_t n)
+{
+    if (s == &overflow) {
+        flush_live(n);
+        return;
+    }
+    s->pending += n;
+    if (s->pending >= LIVE_BATCH || s->pending <= -LIVE_BATCH) {
+        flush_live(s->pending);
+        s->pending = 0;
+    }
+}
+
+// account for a new block
+static void note_alloc(void* p)
+{
+    if (!enabled || !p)
+        return;
+    size_t n = block_size(p);
+    Slot* s = slot();
+    bump(s, s->stats.mallocs, 1);
+    bump(s, s->stats.bytes, n);
+    note_live(s, n);
+}
+
+// account for a block that is about to be freed
+static void note_free(void* p)
+{
+    if (!enabled || !p)
+        return;
+    size_t n = block_size(p);
+    Slot* s = slot();
+    bump(s, s->stats.frees, 1);
+    bump(s, s->stats.freed, n);
+    note_live(s, -(int64_t)n);
+}
+
+extern "C"
+{
+    void* malloc(size_t n)
+    {
+        void* p = (pooling && n <= POOL_MAX) ? pool_alloc(n) : NULL;
+        if (!p)
+            p = __libc_malloc(n);
+        note_alloc(p);
+        return p;
+    }
+
+    void free(void* p)
+    {
+        if (in_pool(p)) {
+            note_free(p);
+            pool_free(p);
+            return;
+        }
+        for (int i = 0, n = nforeign.load(std::memory_order_acquire); i < n; ++i)
+            if ((uintptr_t)p >= foreign_lo[i] && (uintptr_t)p < foreign_hi[i])
+                return;
+        note_free(p);
+        __libc_free(p);
+    }
+
+    void* calloc(size_t n, size_t sz)
+    {
+        // a reused pool block isn't zero, and n * sz mustn't overflow
+        void* p = NULL;
+        if (pooling && sz && n <= POOL_MAX / sz && (p = pool_alloc(n * sz)))
+            memset(p, 0, n * sz);
+        else
+            p = __libc_calloc(n, sz);
+        note_alloc(p);
+        return p;
+    }
+
+    void* realloc(void* p, size_t n)
+    {
+        // a pool block moves, through malloc and free so it is counted
+        if (in_pool(p)) {
+            void* q = n ? malloc(n) : NULL;
+            if (n && !q)
+                return NULL;
+            if (q)
+                memcpy(q, p, std::min(pool_size(p), n));
+            free(p);
+            return q;
+        }
+        note_free(p);
+        void* q = __libc_realloc(p, n);
+        // on failure the old block survives, so put it back
+        note_alloc(q ? q : (n ? p : NULL));
+        return q;
+    }
+
+    void* memalign(size_t align, size_t n)
+    {
+        // pool blocks are only POOL_GRAIN-aligned
+        void* p = (pooling && align <= POOL_GRAIN && n <= POOL_MAX)
+            ? pool_alloc(n) : NULL;
+        if (!p)
+            p = __libc_memalign(align, n);
+        note_alloc(p);
+        return p;
+    }
+
+    void* aligned_alloc(size_t align, size_t n)
+    {
+        return memalign(align, n);
+    }
+
+    int posix_memalign(void** out, size_t align, size_t n)
+    {
+        if (align % sizeof(void*) || (align & (align - 1)))
+            return EINVAL;
+        void* p = memalign(align, n);
+        if (!p)
+            return ENOMEM;
+        *out = p;
+        return 0;
+    }
+}
+
+void alloc_accounting(bool on) { enabled = on; }
+
+bool alloc_accounting() { return enabled; }
+
+void alloc_bind_thread(int id)
+{
+    Slot* s = slot();
+    if (s != &overflow)
+        s->stats.id = id;
+}
+
+AllocStats alloc_total()
+{
+    AllocStats t;
+    int n = nslots.load();
+    for (int i = 0; i <= n; ++i) {
+        const AllocStats& s = (i < n) ? slots[i].stats : overflow.stats;
+        t.mallocs += s.mallocs;
+        t.frees   += s.frees;
+        t.bytes   += s.bytes;
+        t.freed   += s.freed;
+    }
+    return t;
+}
+
+void alloc_threads(std::vector<AllocStats>& out)
+{
+    int n = nslots.load();
+    out.clear();
+    for (int i = 0; i < n; ++i)
+        out.push_back(slots[i].stats);
+}
+
+int64_t alloc_live()
+{
+    int64_t l = live.load();
+    int n = nslots.load();
+    for (int i = 0; i < n; ++i)
+        l += slots[i].pending;
+    return l;
+}
+
+int64_t alloc_peak()
+{
+    return std::max(peak.load(), alloc_live());
+}
+
+void alloc_reset_peak()
+{
+    peak.store(alloc_live());
+}
+
+void alloc_foreign(void* base, size_t len)
+{
+    int i = nforeign.load();
+    if (i == MAX_FOREIGN)
+        return;
+    foreign_lo[i] = (uintptr_t)base;
+    foreign_hi[i] = (uintptr_t)base + len;
+    nforeign.store(i + 1, std::memory_order_release);
+}
+
+void alloc_unforeign(void* base)
+{
+    int n = nforeign.load();
+    for (int i = 0; i < n; ++i) {
+        if (foreign_lo[i] != (uintptr_t)base)
+            continue;
+        // an empty range matches nothing; the last entry can be reused
+        foreign_hi[i] = foreign_lo[i];
+        if (i == n - 1)
+            nforeign.store(i, std::memory_order_release);
+        return;
+    }
+}
+
+bool alloc_hugepages(bool on)
+{
+    if (!on || pooling)
+        return pooling;
+    // over-reserve so the range can start on a 2MB boundary
+    void* r = mmap(NULL, POOL_RESERVE + HUGE_PAGE, PROT_NONE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (r == MAP_FAILED)
+        return false;
+    pool_lo = ((uintptr_t)r + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+    pool_hi = pool_lo + POOL_RESERVE;
+    pooling = true;
+    return true;
+}
+
+HugeStats alloc_huge_stats()
+{
+    HugeStats h;
+    for (int m = 0; m < 3; ++m)
+        h.chunks[m] = pool_got[m];
+    if (!pooling)
+        return h;
+    // sum what the kernel says about the mappings inside the pool range
+    FILE* f = fopen("/proc/self/smaps", "r");
+    if (!f)
+        return h;
+    char line[256];
+    bool mine = false;
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long lo, hi, kb;
+        char perms[8];
+        if (sscanf(line, "%lx-%lx %7s", &lo, &hi, perms) == 3)
+            mine = lo >= pool_lo && hi <= pool_hi;
+        else if (!mine)
+            continue;
+        else if (sscanf(line, "Rss: %lu kB", &kb) == 1)
+            h.rss_bytes += kb << 10;
+        else if (sscanf(line, "AnonHugePages: %lu kB", &kb) == 1)
+            h.huge_bytes += kb << 10;
+        // hugetlb pages aren't in Rss
+        else if (sscanf(line, "Private_Hugetlb: %lu kB", &kb) == 1 ||
+                 sscanf(line, "Shared_Hugetlb: %lu kB", &kb) == 1) {
+            h.huge_bytes += kb << 10;
+            h.rss_bytes += kb << 10;
+        }
+    }
+    fclose(f);
+    return h;
+}
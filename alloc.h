@@ -0,0 +1,89 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Allocation accounting.  alloc.cc wraps malloc and friends (and thereby
+ * operator new, which calls malloc), and when accounting is on, counts calls
+ * and bytes per OS thread, plus each thread's live and peak-live bytes.
+ * Bytes are malloc_usable_size(), i.e., what the allocator really handed
+ * out.  Inside a transaction, libitm's malloc calls go through these
+ * wrappers too, so allocations by aborted attempts are counted.
+ */
+struct AllocStats
+{
+    uint64_t mallocs;                   /// calls to malloc, calloc, etc.
+    uint64_t frees;                     /// calls to free
+    uint64_t bytes;                     /// bytes allocated
+    uint64_t freed;                     /// bytes freed
+    int      id;                        /// harness thread id, or -1
+
+    AllocStats() : mallocs(0), frees(0), bytes(0), freed(0), id(-1) { }
+};
+
+/// Turn counting on or off
+void alloc_accounting(bool on);
+
+/// Is counting on?
+bool alloc_accounting();
+
+/// Label the calling thread's counters with its harness thread id
+void alloc_bind_thread(int id);
+
+/// Sum of all threads' counters
+AllocStats alloc_total();
+
+/// Each thread's counters, by slot.  A slot keeps its thread's counters and
+/// id after the thread exits, until another thread reuses it.
+void alloc_threads(std::vector<AllocStats>& out);
+
+/// Bytes currently live, and the most that were live since the last reset.
+/// Threads add to the live count in batches, so the peak may be short of the
+/// true one by up to 64KB for each thread that was running.
+int64_t alloc_live();
+int64_t alloc_peak();
+void    alloc_reset_peak();
+
+/// Register memory that did not come from malloc (e.g., a mapped image) but
+/// whose blocks may be passed to free().  free() ignores pointers into it.
+void alloc_foreign(void* base, size_t len);
+
+/// Forget a region registered with alloc_foreign, before it is unmapped
+void alloc_unforeign(void* base);
+
+/**
+ * With hugepages on, malloc serves blocks of up to 2KB (the nodes of every
+ * node-based structure here) from per-thread, per-size pools carved out of
+ * 2MB chunks, each of them reserved huge pages (MAP_HUGETLB) if the system
+ * has any left, and an ordinary mapping advised for transparent huge pages
+ * if not.  Turn it on before building the data structures; it can't be
+ * turned off.  Returns whether the pools are in use.
+ */
+bool alloc_hugepages(bool on);
+
+/// How the pools were backed: chunks obtained in each HugeMode (hugemem.h),
+/// and the bytes of the pools that are resident, and resident on huge pages,
+/// per /proc/self/smaps.  THP is only a hint, so huge_bytes is the real
+/// answer for chunks in HUGE_THP mode.
+struct HugeStats
+{
+    uint64_t chunks[3];
+    uint64_t rss_bytes;
+    uint64_t huge_bytes;
+
+    HugeStats() : chunks(), rss_bytes(0), huge_bytes(0) { }
+};
+
+HugeStats alloc_huge_stats();
@@ -4,10 +4,35 @@
 
 /* #include <stdint.h> */
 #include <iostream>
+#include <algorithm>
+#include <cstdint>
 #include <atomic>
+#include <ctime>
 #include <string>
+#include <vector>
 #include <unistd.h>
 
+#include "alloc.h"
+#include "numa.h"
+#include "results.h"
+
+/**
+ * Per-thread results.  The harness used to fold these straight into the
+ * totals, which hides starvation of individual threads under contention.
+ * Latency fields are only filled in when per-op timing (-l) is on.
+ */
+struct ThreadStats
+{
+    uint64_t ops;                       /// transactions committed
+    int      counts[6];                 /// same layout as the totals below
+    uint64_t min_latency;               /// shortest op, in ns
+    uint64_t max_latency;               /// longest op, in ns
+    uint64_t max_gap;                   /// longest time between commits, ns
+
+    ThreadStats() : ops(0), counts(), min_latency(0), max_latency(0),
+                    max_gap(0) { }
+};
+
 /**
  * Standard benchmark configuration globals
  */
@@ -24,6 +49,22 @@ struct Config
     uint32_t    inspct;                 /// insert percent
     uint32_t    sets;                   /// number of sets to create
     uint32_t    ops;                    /// operations per transaction
+    bool        latency;                /// time every operation
+    std::string exec;                   /// how ops run: tm/fc/server/direct
+    uint32_t    producers;              /// service mode: producer threads
+    std::string queue;                  /// service mode: spsc or mpmc
+    uint32_t    queue_depth;            /// service mode: ring capacity
+    bool        alloc_stats;            /// count allocations
+    std::string image;                  /// image file of the warmed set
+    uint32_t    value_size;             /// bytes of value per key (0 = set)
+    uint32_t    verify;                 /// check 1/verify of the set; 0 = skip
+    bool        hugepages;              /// put nodes and buffers on 2MB pages
+    std::string numa;                   /// NUMA placement of the structure
+    bool        generic;                /// never use a compiled workload loop
+    uint32_t    calibrate;              /// txns per calibration pass; 0 = off
+    std::string results;                /// results store to append to
+    std::string program;                /// which benchmark binary this is
+    std::string admission;              /// concurrent txn limit, or "auto"
 
     /*** THESE GET UPDATED LATER ***/
     std::atomic<uint64_t> time;            /// total time the test ran
@@ -35,6 +76,7 @@ struct Config
     std::atomic<int32_t>  insert_miss;     /// total unsuccessful insert txns
     std::atomic<int32_t>  remove_hit;      /// total successful remove txns
     std::atomic<int32_t>  remove_miss;     /// total unsuccessful remove txns
+    std::vector<ThreadStats> thread_stats; /// per-thread breakdown of the above
 
     /// Constructor just sets reasonable defaults for everything
     Config() :
@@ -43,7 +85,16 @@ struct Config
         threads(1),    nops_after_tx(0),
         elements(256), lookpct(34),
         inspct(66),    sets(1),
-        ops(1),        time(0),
+        ops(1),        latency(false),
+        exec("tm"),    producers(0),
+        queue("spsc"), queue_depth(1024),
+        alloc_stats(false), image(""),
+        value_size(0), verify(1),
+        hugepages(false), numa("none"),
+        generic(false), calibrate(0),
+        results(""),   program(""),
+        admission(""),
+        time(0),
         running(true), txcount(0),
         lookup_hit(0), lookup_miss(0),
         insert_hit(0), insert_miss(0),
@@ -58,14 +109,76 @@ struct Config
                   << ", d=" << duration   << ", p=" << threads
                   << ", X=" << execute    << ", m=" << elements
                   << ", S=" << sets       << ", O=" << ops
+                  << ", E=" << exec       << ", V=" << value_size
                   << ", txns=" << txcount << ", time=" << time
                   << ", throughput="
                   << (1000000000LL * txcount) / (time)
                   << std::endl;
+        if (results != "")
+            append_result();
         std::cout << "(l:"  << lookup_hit << "/" << lookup_miss
                   << ", i:" << insert_hit << "/" << insert_miss
                   << ", r:" << remove_hit << "/" << remove_miss
                   << ")" << std::endl;
+        dump_threads();
+    }
+
+    /// Append this run's record to the results store (see results.h)
+    void append_result() {
+        char host[256] = "";
+        gethostname(host, sizeof(host) - 1);
+        std::ostringstream r;
+        r << "result, bench=" << program << ", B=" << bmname
+          << ", R=" << lookpct << ", d=" << duration << ", X=" << execute
+          << ", p=" << threads << ", m=" << elements << ", S=" << sets
+          << ", O=" << ops << ", E=" << exec << ", V=" << value_size
+          << ", N=" << nops_after_tx << ", P=" << producers
+          << ", H=" << hugepages << ", M=" << numa
+          << ", Q=" << queue << ", D=" << queue_depth << ", v=" << verify
+          << ", l=" << latency << ", A=" << alloc_stats << ", G=" << generic
+          << ", i=" << (image != "")
+          << ", a=" << (admission != "" ? admission : "off")
+          << ", txns=" << txcount << ", time=" << time
+          << ", throughput=" << (1000000000LL * txcount) / time
+          << ", when=" << ::time(NULL) << ", host=" << host
+          << ", cc=" << __VERSION__;
+        if (!result_append(results, r.str()))
+            std::cerr << "Could not append to " << results << "\n";
+    }
+
+    /// Print the per-thread table, along with Jain's fairness index and the
+    /// max/min ratio of committed transactions across threads
+    void dump_threads() {
+        if (thread_stats.empty())
+            return;
+        double sum = 0, sumsq = 0;
+        uint64_t mx = 0, mn = UINT64_MAX;
+        for (auto& t : thread_stats) {
+            sum   += t.ops;
+            sumsq += (double)t.ops * t.ops;
+            mx = std::max(mx, t.ops);
+            mn = std::min(mn, t.ops);
+        }
+        double jain = sumsq ? (sum * sum) / (thread_stats.size() * sumsq) : 1;
+        std::cout << "fairness, jain=" << jain << ", max/min=";
+        if (mn)
+            std::cout << (double)mx / mn;
+        else
+            std::cout << "inf";
+        std::cout << ", max=" << mx << ", min=" << mn << std::endl;
+        for (size_t i = 0; i < thread_stats.size(); ++i) {
+            ThreadStats& t = thread_stats[i];
+            std::cout << "thread " << i << ": txns=" << t.ops
+                      << " (l:" << t.counts[0] << "/" << t.counts[1]
+                      << ", i:" << t.counts[2] << "/" << t.counts[3]
+                      << ", r:" << t.counts[4] << "/" << t.counts[5] << ")";
+            // service workers always time their requests
+            if (latency || producers)
+                std::cout << ", lat_min=" << t.min_latency
+                          << ", lat_max=" << t.max_latency
+                          << ", max_gap=" << t.max_gap;
+            std::cout << std::endl;
+        }
     }
 
     /// Print usage
@@ -80,13 +193,47 @@ struct Config
         std::cerr << "    -B: name of benchmark\n";
         std::cerr << "    -S: number of sets to build (default 1)\n";
         std::cerr << "    -O: operations per transaction (default 1)\n";
+        std::cerr << "    -l: time each operation (per-thread latency)\n";
+        std::cerr << "    -E: execution mode: tm, fc (flat combining),\n"
+                  << "        server (delegation), or direct (for sets that\n"
+                  << "        synchronize themselves) (default tm)\n";
+        std::cerr << "    -P: service mode: producer threads feeding the -p\n"
+                  << "        workers through queues (default 0 = off)\n";
+        std::cerr << "    -Q: service mode queue: spsc or mpmc (default spsc)\n";
+        std::cerr << "    -D: service mode queue capacity (default 1024)\n";
+        std::cerr << "    -A: count allocations and report memory footprint\n";
+        std::cerr << "    -i: image file: load the warmed set from it, or\n"
+                  << "        warm up and save to it if it is missing or stale\n";
+        std::cerr << "    -V: bytes of value per key, for structures that are\n"
+                  << "        maps: 4, or a power of 2 from 8 to 1024\n"
+                  << "        (default 0 = keys only)\n";
+        std::cerr << "    -v: verification after the run: full, skip, or\n"
+                  << "        sample<N> to check about 1/N of the set, for\n"
+                  << "        sets that can (default full, sample = 1/16)\n";
+        std::cerr << "    -H: back nodes (allocations up to 2KB) and Disjoint\n"
+                  << "        buffers with 2MB pages: reserved huge pages if\n"
+                  << "        there are any, else transparent huge pages\n";
+        std::cerr << "    -M: NUMA placement of the structure: none, interleave,\n"
+                  << "        owner (each thread warms up its share), or\n"
+                  << "        bind<N>; threads are grouped by node (default none)\n";
+        std::cerr << "    -G: run the generic timed loop, even if the workload\n"
+                  << "        has a compiled one (see workload.h)\n";
+        std::cerr << "    -K: calibrate with this many transactions per pass,\n"
+                  << "        and report the harness and TM begin/commit costs\n"
+                  << "        per transaction, and the set's net cost\n";
+        std::cerr << "    -o: results store: append a record of this run to\n"
+                  << "        the file (compare stores with CompareResults)\n";
+        std::cerr << "    -a: admission control: let at most N threads run\n"
+                  << "        transactions at once, or with auto, find the\n"
+                  << "        limit by hill-climbing on throughput\n";
         std::cerr << "    -h: print help (this message)\n\n";
     }
 
     /// Parse command line arguments
     void parseargs(int argc, char** argv, std::string name) {
+        program = name;
         int opt;
-        while ((opt = getopt(argc, argv, "N:d:p:hX:B:m:R:S:O:")) != -1) {
+        while ((opt = getopt(argc, argv, "N:d:p:hX:B:m:R:S:O:lE:P:Q:D:Ai:V:v:HM:GK:o:a:")) != -1) {
             switch(opt) {
               case 'd': duration      = strtol(optarg, NULL, 10); break;
               case 'p': threads       = strtol(optarg, NULL, 10); break;
@@ -96,14 +243,85 @@ struct Config
               case 'm': elements      = strtol(optarg, NULL, 10); break;
               case 'S': sets          = strtol(optarg, NULL, 10); break;
               case 'O': ops           = strtol(optarg, NULL, 10); break;
-              case 'R':
-                lookpct = strtol(optarg, NULL, 10);
-                inspct = (100 - lookpct)/2 + strtol(optarg, NULL, 10);
-                break;
+              case 'l': latency       = true; break;
+              case 'E': exec          = std::string(optarg); break;
+              case 'P': producers     = strtol(optarg, NULL, 10); break;
+              case 'Q': queue         = std::string(optarg); break;
+              case 'D': queue_depth   = strtol(optarg, NULL, 10); break;
+              case 'A': alloc_stats   = true; break;
+              case 'i': image         = std::string(optarg); break;
+              case 'V': value_size    = strtol(optarg, NULL, 10); break;
+              case 'v': verify        = parse_verify(optarg); break;
+              case 'H': hugepages     = true; break;
+              case 'M': numa          = std::string(optarg); break;
+              case 'G': generic       = true; break;
+              case 'K': calibrate     = strtol(optarg, NULL, 10); break;
+              case 'o': results       = std::string(optarg); break;
+              case 'a': admission     = std::string(optarg); break;
+              case 'R': set_lookups(strtol(optarg, NULL, 10)); break;
               case 'h':
                 usage(name);
             }
         }
+        // start counting now, so allocations made while building the
+        // benchmark's data structures are seen too
+        alloc_accounting(alloc_stats);
+        // likewise, the pools have to be there before the first node is
+        if (hugepages && !alloc_hugepages(true))
+            std::cerr << "Could not reserve address space for -H\n";
+        if (queue != "spsc" && queue != "mpmc") {
+            std::cerr << "Unknown service queue " << queue << "\n";
+            exit(1);
+        }
+        if (!NumaPlacement::get().parse(numa)) {
+            std::cerr << "Unknown NUMA placement " << numa << "\n";
+            exit(1);
+        }
+        NumaPlacement::get().setup();
+    }
+
+    /// -R: pct% lookups, and the rest split evenly between inserts and
+    /// removes
+    void set_lookups(uint32_t pct) {
+        lookpct = pct;
+        inspct = (100 - pct)/2 + pct;
+    }
+
+    /// Zero everything that a run updates, so that one process can do
+    /// several runs
+    void reset_counters() {
+        time = 0;
+        running = true;
+        txcount = 0;
+        lookup_hit = 0;
+        lookup_miss = 0;
+        insert_hit = 0;
+        insert_miss = 0;
+        remove_hit = 0;
+        remove_miss = 0;
+        thread_stats.clear();
+    }
+
+    /// -v full is 1, skip is 0, and sample<N> is N
+    static uint32_t parse_verify(const std::string& mode) {
+        if (mode == "full")
+            return 1;
+        if (mode == "skip")
+            return 0;
+        if (mode.compare(0, 6, "sample") == 0) {
+            int n = (mode.size() > 6) ? atoi(mode.c_str() + 6) : 16;
+            if (n >= 1)
+                return n;
+        }
+        std::cerr << "Unknown verification mode " << mode << "\n";
+        exit(1);
+    }
+
+    /// Read the running flag without instrumentation, so that a transaction
+    /// that keeps aborting can still see that the experiment is over
+    __attribute__((transaction_pure))
+    static bool still_running() {
+        return CFG.running;
     }
 
     /// we can call this from an alarm signal handler to stop the experiment
@@ -20,6 +20,14 @@
 #include "barrier.h"
 #include "timing.h"
 #include "bmconfig.h"
+#include "combining.h"
+#include "service.h"
+#include "verify.h"
+#include "image.h"
+#include "hugemem.h"
+#include "workload.h"
+#include "NullSet.h"
+#include "admission.h"
 
 #ifdef LU_GCC
 extern "C"
@@ -40,32 +48,125 @@ class benchmark
     /// A barrier for ensuring all threads move forward together
     barrier* thread_barrier;
 
+    /// When not using TM, the combiner that applies everyone's requests
+    combiner<SET>* delegate;
+
+    /// A benchmark's own operation, to run instead of the IntSet mix
+    bool (*custom_op)(SET* set, uint32_t id, uint32_t* seed);
+
+    /// Allocation accounting: elements and live bytes added by warmup, the
+    /// live bytes before it (so that footprint counts only this set, even
+    /// if others were built before it), the elements as of the last run
+    /// (a set can be run more than once, as in SuiteBench), and the
+    /// counters as they stood when the timed run began
+    int64_t warm_elems;
+    int64_t warm_live;
+    int64_t base_live;
+    int64_t set_elems;
+    AllocStats run_start;
+    std::vector<AllocStats> run_start_threads;
+
+    /// The timed loop compiled for this run's workload, if it is one of
+    /// WORKLOADS (workload.h); it returns the transaction count
+    typedef uint32_t (benchmark::*fixed_loop)(uint32_t* seed, int counts[]);
+    fixed_loop loop;
+
+    /// -a: the admission controller, if any
+    Admission* admit;
+
+    /// -K: ns per transaction of the harness alone, and of the harness with
+    /// an empty transaction
+    double cal_bare;
+    double cal_empty;
+
+    /// Run one operation, either through the combiner, or as a transaction
+    /// (directly, if the SET is concurrent)
+    bool execute(uint32_t id, int op, uint32_t val) {
+        if (delegate)
+            return delegate->apply(id, op, val);
+        return run_op(set, op, val);
+    }
+
     /// Each iteration of the test will decide whether to insert, lookup, or
     /// remove
     void test_iteration(uint32_t id, uint32_t* seed, int counts[]) {
+        if (custom_op) {
+            counts[custom_op(set, id, seed) ? 0 : 1]++;
+            return;
+        }
         uint32_t val = rand_r_32(seed) % Config::CFG.elements;
         uint32_t act = rand_r_32(seed) % 100;
         bool res;
         if (act < Config::CFG.lookpct) {
-            __transaction_atomic {
-                res = set->lookup(val);
-            }
+            res = execute(id, OP_LOOKUP, val);
             counts[res?0:1]++;
         }
         else if (act < Config::CFG.inspct) {
-            __transaction_atomic {
-                res = set->insert(val);
-            }
+            res = execute(id, OP_INSERT, val);
             counts[res?2:3]++;
         }
         else {
-            __transaction_atomic {
-                res = set->remove(val);
-            }
+            res = execute(id, OP_REMOVE, val);
             counts[res?4:5]++;
         }
     }
 
+    /// test_iteration for workload W, with the mix and think time folded in
+    /// and the key range read once, by the caller.  Out of line, so that the
+    /// caller's loop variables aren't live across the transaction's begin.
+    template<class W>
+    __attribute__((noinline))
+    void fixed_iteration(uint32_t* seed, int counts[], uint32_t range) {
+        uint32_t val = W::keys::next(seed, range);
+        uint32_t act = rand_r_32(seed) % 100;
+        if (act < W::lookpct)
+            counts[run_op(set, OP_LOOKUP, val) ? 0 : 1]++;
+        else if (act < W::inspct)
+            counts[run_op(set, OP_INSERT, val) ? 2 : 3]++;
+        else
+            counts[run_op(set, OP_REMOVE, val) ? 4 : 5]++;
+        W::think();
+    }
+
+    /// The timed loop for workload W
+    template<class W>
+    uint32_t run_fixed(uint32_t* seed, int counts[]) {
+        const uint32_t range = W::keys::range(Config::CFG.elements);
+        const uint32_t fixed_count = Config::CFG.execute;
+        uint32_t count = 0;
+        if (fixed_count)
+            for (; count < fixed_count; ++count)
+                fixed_iteration<W>(seed, counts, range);
+        else
+            for (; Config::CFG.running; ++count)
+                fixed_iteration<W>(seed, counts, range);
+        return count;
+    }
+
+    /// The compiled loop for this run, or NULL if it needs the generic one:
+    /// because the workload isn't in WORKLOADS, or because of -G, -l, a
+    /// custom op, a combiner, or admission control.  'name' says which.
+    fixed_loop pick_loop(std::string& name) {
+        name = "generic";
+        if (Config::CFG.generic || Config::CFG.latency || custom_op ||
+            delegate || admit)
+            return NULL;
+        uint32_t n = Config::CFG.elements;
+        bool pow2 = n && !(n & (n - 1));
+#define WORKLOAD_CASE(L, I, N)                                          \
+        if (Config::CFG.lookpct == L && Config::CFG.inspct == I &&      \
+            Config::CFG.nops_after_tx == N)                             \
+        {                                                               \
+            name = "fixed(" #L "/" #I "/" #N ")";                       \
+            return pow2                                                 \
+                ? &benchmark::run_fixed<Workload<L, I, N, Pow2Keys> >   \
+                : &benchmark::run_fixed<Workload<L, I, N, ModKeys> >;   \
+        }
+        WORKLOADS(WORKLOAD_CASE)
+#undef WORKLOAD_CASE
+        return NULL;
+    }
+
     /// This code runs some no-ops between transactions, if requested
     void nontxnwork() {
         if (Config::CFG.nops_after_tx)
@@ -73,12 +174,49 @@ class benchmark
                 __asm__ __volatile__("nop");
     }
 
+    /// Run one iteration once the admission controller, if any, lets us
+    void admitted_iteration(uint32_t id, uint32_t* seed, int counts[]) {
+        if (!admit) {
+            test_iteration(id, seed, counts);
+            return;
+        }
+        int token = admit->acquire(id);
+        test_iteration(id, seed, counts);
+        admit->release(id, token);
+    }
+
+    /// Run one iteration, and if per-op timing is on, track its latency and
+    /// the gap since this thread's previous commit
+    void timed_iteration(uint32_t id, uint32_t* seed, int counts[],
+                         ThreadStats& stats, uint64_t& last)
+    {
+        if (!Config::CFG.latency) {
+            admitted_iteration(id, seed, counts);
+            return;
+        }
+        uint64_t start = getElapsedTime();
+        admitted_iteration(id, seed, counts);
+        uint64_t end = getElapsedTime();
+        uint64_t lat = end - start;
+        if (stats.min_latency == 0 || lat < stats.min_latency)
+            stats.min_latency = lat;
+        if (lat > stats.max_latency)
+            stats.max_latency = lat;
+        if (end - last > stats.max_gap)
+            stats.max_gap = end - last;
+        last = end;
+    }
+
     /// This oversees the repeated execution of test_iteration, which will be
     /// performed based on timing, or a fixed number of operations, depending
     /// on the configuration of this experiment
     void run(uintptr_t id) {
         // set thread id
         thread_id = id;
+        if (Config::CFG.alloc_stats)
+            alloc_bind_thread(id);
+        NumaPlacement::get().bind_thread(id, Config::CFG.threads);
+        init_thread(set, id, 0);
         // wait until all threads created, then set alarm and read timer
         thread_barrier->arrive(id);
         if (id == 0) {
@@ -97,10 +235,15 @@ class benchmark
         int counts[6] = {0, 0, 0, 0, 0, 0};
         uint32_t count = 0;
         uint32_t seed = id; // not everyone needs a seed, but we have to support it
-        if (!Config::CFG.execute) {
+        ThreadStats stats;
+        uint64_t last = Config::CFG.latency ? getElapsedTime() : 0;
+        if (loop) {
+            count = (this->*loop)(&seed, counts);
+        }
+        else if (!Config::CFG.execute) {
             // run txns until alarm fires
             while (Config::CFG.running) {
-                test_iteration(id, &seed, counts);
+                timed_iteration(id, &seed, counts, stats, last);
                 ++count;
                 nontxnwork(); // some nontx work between txns?
             }
@@ -108,7 +251,7 @@ class benchmark
         else {
             // run fixed number of txns
             for (uint32_t e = 0; e < Config::CFG.execute; e++) {
-                test_iteration(id, &seed, counts);
+                timed_iteration(id, &seed, counts, stats, last);
                 ++count;
                 nontxnwork(); // some nontx work between txns?
             }
@@ -127,6 +270,12 @@ class benchmark
         Config::CFG.insert_miss += counts[3];
         Config::CFG.remove_hit  += counts[4];
         Config::CFG.remove_miss += counts[5];
+
+        // keep the per-thread breakdown too
+        stats.ops = count;
+        for (int i = 0; i < 6; ++i)
+            stats.counts[i] = counts[i];
+        Config::CFG.thread_stats[id] = stats;
     }
 
     /// wrapper for running the experiments, since threads can't call methods
@@ -141,28 +290,326 @@ class benchmark
         b->thread_barrier->arrive(i);
     }
 
+    /// Report footprint per element and allocations per transaction.  Call
+    /// once after each run: it carries the element count forward.
+    void dump_alloc() {
+        AllocStats t = alloc_total();
+        uint64_t mallocs = t.mallocs - run_start.mallocs;
+        uint64_t frees   = t.frees - run_start.frees;
+        uint32_t txns    = Config::CFG.txcount;
+        std::cout << "alloc, live_bytes=" << alloc_live()
+                  << ", peak_bytes=" << alloc_peak();
+        // per-element numbers only make sense if warmup built a set
+        if (warm_elems) {
+            set_elems += Config::CFG.insert_hit - Config::CFG.remove_hit;
+            int64_t live = alloc_live() - base_live;
+            std::cout << ", warm_elems=" << warm_elems
+                      << ", warm_bytes/elem=" << (double)warm_live / warm_elems
+                      << ", end_elems=" << set_elems << ", end_bytes/elem="
+                      << (set_elems ? (double)live / set_elems : 0);
+        }
+        std::cout << ", mallocs=" << mallocs << ", frees=" << frees
+                  << ", mallocs/txn=" << (txns ? (double)mallocs / txns : 0)
+                  << ", frees/txn=" << (txns ? (double)frees / txns : 0)
+                  << std::endl;
+        std::vector<AllocStats> threads;
+        alloc_threads(threads);
+        for (size_t i = 0; i < threads.size(); ++i) {
+            if (threads[i].id < 0)
+                continue;
+            AllocStats b = i < run_start_threads.size()
+                ? run_start_threads[i] : AllocStats();
+            // a slot left by a thread of an earlier run
+            if (threads[i].mallocs == b.mallocs && threads[i].frees == b.frees)
+                continue;
+            std::cout << "alloc thread " << threads[i].id
+                      << ": mallocs=" << threads[i].mallocs - b.mallocs
+                      << ", frees=" << threads[i].frees - b.frees
+                      << ", bytes=" << threads[i].bytes - b.bytes
+                      << ", freed=" << threads[i].freed - b.freed
+                      << std::endl;
+        }
+    }
+
   public:
 
     /// The constructor doesn't build a barrier, because we don't know the
     /// thread count yet
-    benchmark() : set(new SET()), thread_barrier(NULL) { }
+    benchmark()
+        : set(new SET()), thread_barrier(NULL), delegate(NULL),
+          custom_op(NULL), warm_elems(0), warm_live(0), base_live(0),
+          set_elems(0), loop(NULL),
+          admit(NULL), cal_bare(0), cal_empty(0)
+    { }
 
     /// An alternative constructor that takes a pre-constructed SET
-    benchmark(SET* _set) : set(_set), thread_barrier(NULL) { }
+    benchmark(SET* _set)
+        : set(_set), thread_barrier(NULL), delegate(NULL),
+          custom_op(NULL), warm_elems(0), warm_live(0), base_live(0),
+          set_elems(0), loop(NULL),
+          admit(NULL), cal_bare(0), cal_empty(0)
+    { }
+
+    /// A benchmark can replace the IntSet mix with its own operation, which
+    /// runs once per iteration and makes its own transaction.  Results are
+    /// tallied in the lookup columns.
+    typedef bool (*iteration_op)(SET* set, uint32_t id, uint32_t* seed);
+
+    void set_op(iteration_op op) { custom_op = op; }
+
+    /// Time n iterations of the timed loop on the calling thread, outside
+    /// of a run and without adding to its counters
+    uint64_t time_loop(uint32_t n) {
+        std::string name;
+        loop = pick_loop(name);
+        uint32_t saved = Config::CFG.execute;
+        Config::CFG.execute = n;
+        int counts[6] = {0, 0, 0, 0, 0, 0};
+        uint32_t seed = 0;
+        ThreadStats stats;
+        uint64_t last = 0;
+        uint64_t start = getElapsedTime();
+        if (loop) {
+            (this->*loop)(&seed, counts);
+        }
+        else {
+            for (uint32_t e = 0; e < n; e++) {
+                timed_iteration(0, &seed, counts, stats, last);
+                nontxnwork();
+            }
+        }
+        uint64_t time = getElapsedTime() - start;
+        Config::CFG.execute = saved;
+        return time;
+    }
+
+    /// -K: time the same loop against a NullSet, with and without empty
+    /// transactions, taking the best of three passes of each
+    void calibrate() {
+        uint32_t n = Config::CFG.calibrate;
+        benchmark<NullSet<false> > bare(new NullSet<false>());
+        benchmark<NullSet<true> > empty(new NullSet<true>());
+        uint64_t b = ~0ull, e = ~0ull;
+        for (int pass = 0; pass < 3; ++pass) {
+            b = std::min(b, bare.time_loop(n));
+            e = std::min(e, empty.time_loop(n));
+        }
+        cal_bare = (double)b / n;
+        cal_empty = (double)e / n;
+    }
+
+    /// Split the run's cost per transaction (per thread) into harness, TM
+    /// begin/commit, and what is left, which is the set's own cost
+    void dump_calibration() {
+        uint32_t txns = Config::CFG.txcount;
+        double full = txns ? (double)Config::CFG.time * Config::CFG.threads
+                             / txns : 0;
+        double base = concurrent_set<SET>(0) ? cal_bare : cal_empty;
+        std::cout << "calibrate, txns=" << Config::CFG.calibrate
+                  << ", harness_ns=" << cal_bare
+                  << ", tm_ns=" << (concurrent_set<SET>(0) ? 0
+                                    : cal_empty - cal_bare)
+                  << ", full_ns=" << full
+                  << ", net_ns=" << full - base << std::endl;
+    }
+
+    /// Refuse to run more threads than the SET has per-thread state for.
+    /// The -E server combiner runs as one more thread.
+    void check_threads() {
+        int ids = Config::CFG.threads + (Config::CFG.exec == "server" &&
+                                         !Config::CFG.producers ? 1 : 0);
+        if (ids > set_max_threads<SET>(0)) {
+            std::cerr << Config::CFG.bmname << " supports at most "
+                      << set_max_threads<SET>(0) << " threads"
+                      << (Config::CFG.exec == "server"
+                          ? ", counting the -E server thread" : "") << "\n";
+            exit(1);
+        }
+    }
+
+    /// With -M owner, each thread inserts its own range of the keys from the
+    /// node it will run on, so first touch puts those nodes near it
+    void owner_warmup() {
+        uint32_t threads = Config::CFG.threads;
+        uint64_t range = (uint64_t)Config::CFG.elements + 1;
+        std::atomic<int64_t> elems(0);
+        std::vector<std::thread> builders;
+        for (uint32_t t = 0; t < threads; ++t)
+            builders.push_back(std::thread([this, t, threads, range, &elems] {
+                thread_id = t;
+                NumaPlacement::get().bind_thread(t, threads);
+                int64_t n = 0;
+                for (int32_t w = Config::CFG.elements; w >= 0; w-=2)
+                    if ((uint64_t)w * threads / range == t)
+                        n += run_op(set, OP_INSERT, w);
+                elems += n;
+            }));
+        for (std::thread& b : builders)
+            b.join();
+        warm_elems += elems;
+    }
 
     /// warm up the data structure in a repeatable way
     void warmup() {
+        check_threads();
+
+        // if there's an image of the warmed set, use it instead
+        const char* img = Config::CFG.image.c_str();
+        if (*img) {
+            uint64_t start = getElapsedTime();
+            if (image_load(set, img, Config::CFG.elements, 0)) {
+                std::cout << "image, loaded=" << img << ", time="
+                          << getElapsedTime() - start << std::endl;
+                return;
+            }
+        }
+
+        base_live = alloc_live();
         // warm up the datastructure
-        for (int32_t w = Config::CFG.elements; w >= 0; w-=2)
-            set->insert(w);
-        assert(set->isSane());
+        if (NumaPlacement::get().owner())
+            owner_warmup();
+        else
+            for (int32_t w = Config::CFG.elements; w >= 0; w-=2)
+                warm_elems += set->insert(w);
+        assert(!Config::CFG.verify ||
+               verify_set(set, Config::CFG.threads, Config::CFG.verify, 0));
+        warm_live = alloc_live() - base_live;
+        set_elems = warm_elems;
+
+        if (*img) {
+            bool ok = image_save(set, img, Config::CFG.elements, 0);
+            std::cout << "image, " << (ok ? "saved=" : "not saved=") << img
+                      << std::endl;
+        }
+    }
+
+    /// Check the set as -v says to, using all of the benchmark's threads,
+    /// and report how long it took
+    void verify() {
+        if (!Config::CFG.verify) {
+            std::cout << "Verification: Skipped\n";
+            return;
+        }
+        uint64_t start = getElapsedTime();
+        bool v = verify_set(set, Config::CFG.threads, Config::CFG.verify, 0);
+        std::cout << "Verification: " << (v ? "Passed" : "Failed") << "\n";
+        std::cout << "verify, sample=" << Config::CFG.verify << ", time="
+                  << getElapsedTime() - start << std::endl;
+    }
+
+    /// Say how -H's pools were really backed: the chunks got from each
+    /// source, and how much of what is resident is on huge pages
+    void dump_huge() {
+        HugeStats h = alloc_huge_stats();
+        uint64_t chunks = h.chunks[HUGE_TLB] + h.chunks[HUGE_THP]
+                        + h.chunks[HUGE_NONE];
+        HugeMode mode = h.chunks[HUGE_NONE] ? HUGE_NONE
+                      : h.chunks[HUGE_THP] ? HUGE_THP : HUGE_TLB;
+        std::cout << "hugepages, mode=" << (chunks ? huge_name(mode) : "none")
+                  << ", chunks=" << chunks
+                  << ", hugetlb=" << h.chunks[HUGE_TLB]
+                  << ", thp=" << h.chunks[HUGE_THP]
+                  << ", rss_bytes=" << h.rss_bytes
+                  << ", huge_bytes=" << h.huge_bytes
+                  << ", huge%=" << (h.rss_bytes ? 100.0 * h.huge_bytes
+                                                  / h.rss_bytes : 0)
+                  << std::endl;
     }
 
     /// Create threads and a barrier, then run the tests
     void launch_test() {
+        check_threads();
+        run_start = alloc_total();
+        alloc_threads(run_start_threads);
+        alloc_reset_peak();
+
+        // custom operations make their own transactions, so they can't be
+        // queued or combined
+        if (custom_op && (Config::CFG.producers || Config::CFG.exec != "tm")) {
+            std::cerr << "This benchmark only runs with -E tm and no -P\n";
+            exit(1);
+        }
+
+        // service mode has its own producer and worker threads
+        if (Config::CFG.producers) {
+            if (Config::CFG.admission != "") {
+                std::cerr << "Admission control (-a) doesn't apply to"
+                          << " service mode (-P)\n";
+                exit(1);
+            }
+            // workers run each request as a transaction, or directly for
+            // a concurrent set; there is no combiner
+            if (Config::CFG.exec != "tm") {
+                std::cerr << "Service mode (-P) runs with -E tm only\n";
+                exit(1);
+            }
+            if (Config::CFG.calibrate)
+                std::cout << "calibrate, skipped: service mode (-P) has no"
+                          << " harness loop to calibrate" << std::endl;
+            service<SET>(set).launch();
+            verify();
+            if (Config::CFG.alloc_stats)
+                dump_alloc();
+            if (Config::CFG.hugepages)
+                dump_huge();
+            NumaPlacement::get().report();
+            return;
+        }
+
         if (thread_barrier != NULL)
             delete(thread_barrier);
         thread_barrier = new barrier(Config::CFG.threads);
+        Config::CFG.thread_stats.assign(Config::CFG.threads, ThreadStats());
+
+        // pick the execution backend.  Concurrent SETs don't use TM, so for
+        // them "tm" means "direct"
+        if (concurrent_set<SET>(0) && Config::CFG.exec == "tm")
+            Config::CFG.exec = "direct";
+        if (Config::CFG.exec == "fc" || Config::CFG.exec == "server") {
+            delegate = new combiner<SET>(set, Config::CFG.threads,
+                                         Config::CFG.exec == "server");
+        }
+        else if (Config::CFG.exec == "direct" && !concurrent_set<SET>(0)) {
+            std::cerr << "Execution mode direct needs a concurrent set\n";
+            exit(1);
+        }
+        else if (Config::CFG.exec != "tm" && Config::CFG.exec != "direct") {
+            std::cerr << "Unknown execution mode " << Config::CFG.exec << "\n";
+            exit(1);
+        }
+
+        // -a: auto, or a fixed limit on concurrent transactions
+        if (Config::CFG.admission != "") {
+            uint32_t fixed = strtol(Config::CFG.admission.c_str(), NULL, 10);
+            if (Config::CFG.exec != "tm" ||
+                (!fixed && Config::CFG.admission != "auto")) {
+                std::cerr << "Admission control is -a auto or -a <limit>,"
+                          << " with -E tm\n";
+                exit(1);
+            }
+        }
+
+        // calibrate on this thread before the others exist
+        bool calibrated = Config::CFG.calibrate && !custom_op && !delegate;
+        if (Config::CFG.calibrate && !calibrated)
+            std::cout << "calibrate, skipped: needs the IntSet mix with -E tm"
+                      << " or direct" << std::endl;
+        if (calibrated)
+            calibrate();
+
+        if (Config::CFG.admission != "")
+            admit = new Admission(Config::CFG.threads,
+                                  strtol(Config::CFG.admission.c_str(),
+                                         NULL, 10));
+
+        std::string name;
+        loop = pick_loop(name);
+        std::cout << "workload, loop=" << name;
+        if (loop)
+            std::cout << ", keys="
+                      << ((Config::CFG.elements & (Config::CFG.elements - 1))
+                          ? ModKeys::name() : Pow2Keys::name());
+        std::cout << std::endl;
 
         // kick off the threads (this thread runs too...)
         std::thread* threads = new std::thread[Config::CFG.threads];
@@ -175,8 +622,29 @@ class benchmark
         for (int i = 1; i < Config::CFG.threads; ++i)
             threads[i].join();
 
+        // stop adapting, and say what the limit did
+        if (admit) {
+            admit->finish();
+            admit->report();
+            delete admit;
+            admit = NULL;
+        }
+
+        // shut down the combiner, if any
+        if (delegate) {
+            delegate->report();
+            delete delegate;
+            delegate = NULL;
+        }
+
         // test for correctness
-        bool v = set->isSane();
-        std::cout << "Verification: " << (v ? "Passed" : "Failed") << "\n";
+        verify();
+        if (Config::CFG.alloc_stats)
+            dump_alloc();
+        if (Config::CFG.hugepages)
+            dump_huge();
+        NumaPlacement::get().report();
+        if (calibrated)
+            dump_calibration();
     }
 };
@@ -0,0 +1,212 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <thread>
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+extern thread_local int thread_id;
+
+/// The three IntSet operations, so that requests can be passed around
+enum SetOp { OP_LOOKUP, OP_INSERT, OP_REMOVE };
+
+/// Apply an IntSet operation to a SET.  For a SET whose methods are
+/// transaction_safe, GCC infers that this is too, so it can be called both
+/// inside and outside of a transaction.
+template<class SET>
+inline bool apply_op(SET* set, int op, int val)
+{
+    switch (op) {
+      case OP_LOOKUP: return set->lookup(val);
+      case OP_INSERT: return set->insert(val);
+      default:        return set->remove(val);
+    }
+}
+
+/// A SET that synchronizes for itself (e.g., a lock-free list) declares
+/// "static const bool concurrent = true", and its operations are then run
+/// directly instead of in transactions.  Everything else is a TM set.
+template<class SET>
+constexpr auto concurrent_set(int) -> decltype(SET::concurrent, bool())
+{
+    return SET::concurrent;
+}
+
+template<class SET>
+constexpr bool concurrent_set(long) { return false; }
+
+template<class SET>
+inline bool run_op(SET* set, int op, int val, std::true_type)
+{
+    return apply_op(set, op, val);
+}
+
+template<class SET>
+inline bool run_op(SET* set, int op, int val, std::false_type)
+{
+    bool res;
+    __transaction_atomic {
+        res = apply_op(set, op, val);
+    }
+    return res;
+}
+
+/// A SET that keeps per-thread state in a fixed-size array, indexed by
+/// thread_id, declares "static const int max_threads", and the harness
+/// refuses to run more threads than that.  Call with 0.
+template<class SET>
+constexpr auto set_max_threads(int) -> decltype(SET::max_threads, int())
+{
+    return SET::max_threads;
+}
+
+template<class SET>
+constexpr int set_max_threads(long) { return INT_MAX; }
+
+/// A SET that wants per-thread setup (e.g., to first-touch its own memory)
+/// provides thread_init(id), which each thread calls before the timed run.
+/// Call with 0 as the last argument.
+template<class SET>
+auto init_thread(SET* set, int id, int) -> decltype(set->thread_init(id))
+{
+    return set->thread_init(id);
+}
+
+template<class SET>
+void init_thread(SET*, int, long) { }
+
+/// Run one IntSet operation the way SET needs it run: as a transaction, or
+/// directly if SET is concurrent
+template<class SET>
+inline bool run_op(SET* set, int op, int val)
+{
+    return run_op(set, op, val,
+                  std::integral_constant<bool, concurrent_set<SET>(0)>());
+}
+
+/**
+ * An execution backend that does not use TM at all.  Each thread publishes
+ * its request in its own slot, and a single thread applies every published
+ * request to the (unmodified) SET, sequentially.
+ *
+ * In flat-combining mode, whichever requester grabs the lock becomes the
+ * combiner for a batch.  In delegation mode, a dedicated server thread (not
+ * counted in -p) is the only one that ever touches the SET.
+ */
+template<class SET>
+class combiner
+{
+    /// A request slot.  Padded to two lines, since new[] won't align it and
+    /// the adjacent-line prefetcher would otherwise pair slots up.
+    struct Slot
+    {
+        std::atomic<int> req;           /// 0 when empty, else op + 1
+        int              val;
+        bool             res;
+        char             padding[128 - 2*sizeof(int) - sizeof(bool)];
+        Slot() : req(0), val(0), res(false) { }
+    };
+
+    /// The data structure all requests are applied to
+    SET* set;
+
+    /// One slot per benchmark thread
+    Slot* slots;
+    uint32_t nslots;
+
+    /// The combiner lock (unused in delegation mode)
+    std::atomic<bool> lock;
+
+    /// Delegation mode: the server and the flag that shuts it down
+    bool dedicated;
+    std::thread server;
+    std::atomic<bool> done;
+
+    /// Batches, and requests applied in them.  Only the combiner writes
+    /// these.
+    uint64_t batches;
+    uint64_t applied;
+
+    /// Make one pass over the slots and apply every pending request.  We
+    /// impersonate the requester, since some SETs key on thread_id.
+    void combine() {
+        int me = thread_id;
+        uint64_t found = 0;
+        for (uint32_t i = 0; i < nslots; ++i) {
+            int r = slots[i].req.load(std::memory_order_acquire);
+            if (r == 0)
+                continue;
+            thread_id = i;
+            slots[i].res = apply_op(set, r - 1, slots[i].val);
+            slots[i].req.store(0, std::memory_order_release);
+            ++found;
+        }
+        thread_id = me;
+        if (found) {
+            ++batches;
+            applied += found;
+        }
+    }
+
+    /// The dedicated server just combines until told to stop
+    void serve() {
+        thread_id = nslots;
+        while (!done.load(std::memory_order_relaxed))
+            combine();
+    }
+
+  public:
+
+    combiner(SET* _set, uint32_t threads, bool _dedicated)
+        : set(_set), slots(new Slot[threads]), nslots(threads), lock(false),
+          dedicated(_dedicated), done(false), batches(0), applied(0)
+    {
+        if (dedicated)
+            server = std::thread(&combiner::serve, this);
+    }
+
+    ~combiner() {
+        if (dedicated) {
+            done = true;
+            server.join();
+        }
+        delete[] slots;
+    }
+
+    /// Publish a request from thread id, and wait for it to be applied
+    bool apply(uint32_t id, int op, int val) {
+        Slot& s = slots[id];
+        s.val = val;
+        s.req.store(op + 1, std::memory_order_release);
+        while (true) {
+            if (!dedicated && !lock.load(std::memory_order_relaxed) &&
+                !lock.exchange(true, std::memory_order_acquire))
+            {
+                combine();
+                lock.store(false, std::memory_order_release);
+            }
+            if (s.req.load(std::memory_order_acquire) == 0)
+                return s.res;
+        }
+    }
+
+    /// Print how well requests were batched
+    void report() {
+        std::cout << "combining, mode=" << (dedicated ? "server" : "fc")
+                  << ", batches=" << batches
+                  << ", ops/batch=" << (batches ? (double)applied / batches : 0)
+                  << std::endl;
+    }
+};
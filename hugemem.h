@@ -0,0 +1,65 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+#include <sys/mman.h>
+#include <cstdlib>
+#include <cstdint>
+
+/// How a region ended up being backed
+enum HugeMode { HUGE_NONE, HUGE_THP, HUGE_TLB };
+
+/// the size of a huge page, which huge regions are rounded up to
+static const size_t HUGE_PAGE = 2 * 1024 * 1024;
+
+inline const char* huge_name(HugeMode m)
+{
+    return (m == HUGE_TLB) ? "hugetlb" : (m == HUGE_THP) ? "thp" : "none";
+}
+
+/**
+ * Get 'bytes' of memory, aligned to at least 128 bytes.  If 'huge' is set,
+ * try for reserved huge pages (MAP_HUGETLB) first, then for an ordinary
+ * mapping that asks for transparent huge pages; 'got' says which one worked.
+ * THP is only a hint, so "thp" means the kernel was asked, not that it
+ * complied.  Without 'huge' this is just an aligned malloc.
+ */
+inline void* huge_alloc(size_t bytes, bool huge, HugeMode& got)
+{
+    got = HUGE_NONE;
+    if (!huge) {
+        void* p;
+        return (posix_memalign(&p, 128, bytes) == 0) ? p : NULL;
+    }
+    size_t len = (bytes + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+    void* p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+        got = HUGE_TLB;
+        return p;
+    }
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+    if (madvise(p, len, MADV_HUGEPAGE) == 0)
+        got = HUGE_THP;
+    return p;
+}
+
+/// Give back memory from huge_alloc; 'huge' must match the allocation
+inline void huge_free(void* p, size_t bytes, bool huge)
+{
+    if (!huge)
+        free(p);
+    else
+        munmap(p, (bytes + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1));
+}
@@ -0,0 +1,164 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+#include "alloc.h"
+
+/**
+ * Images of warmed data structures.  An image is a header followed by an
+ * array of nodes, laid out exactly as in memory except that every pointer
+ * holds a byte offset from the start of the file (0 for NULL).  Loading maps
+ * the file privately and adds the mapping's base to every pointer, which is
+ * far cheaper than rebuilding a large structure one insert at a time.  The
+ * mapping is registered with alloc.cc, so free() of a loaded node (e.g., by
+ * remove) is a no-op.
+ */
+struct ImageHeader
+{
+    char     magic[8];                  /// "tmubimg"
+    char     kind[16];                  /// which data structure
+    uint32_t ptr_size;                  /// sizeof(void*) of the writer
+    uint32_t node_size;                 /// sizeof one node
+    uint64_t nodes;                     /// node count, including sentinels
+    uint64_t elements;                  /// the -m value it was built for
+    char     padding[64 - 8 - 16 - 4 - 4 - 8 - 8];
+};
+
+/// The in-file "pointer" to node number idx
+template<class T>
+inline T* image_offset(uint64_t idx)
+{
+    return (T*)(uintptr_t)(sizeof(ImageHeader) + idx * sizeof(T));
+}
+
+/// Turn an in-file offset back into a pointer, once the image is mapped
+template<class T>
+inline void image_relocate(char* base, T*& p)
+{
+    if (p)
+        p = (T*)(base + (uintptr_t)p);
+}
+
+/// Streams nodes into an image file
+class image_writer
+{
+    FILE*       f;
+    ImageHeader h;
+
+  public:
+
+    image_writer(const char* path, const char* kind, uint32_t node_size,
+                 uint64_t elements)
+        : f(fopen(path, "wb")), h()
+    {
+        strncpy(h.magic, "tmubimg", sizeof(h.magic));
+        strncpy(h.kind, kind, sizeof(h.kind) - 1);
+        h.ptr_size = sizeof(void*);
+        h.node_size = node_size;
+        h.elements = elements;
+        // placeholder, rewritten by finish()
+        if (f && fwrite(&h, sizeof(h), 1, f) != 1) {
+            fclose(f);
+            f = NULL;
+        }
+    }
+
+    ~image_writer() { if (f) fclose(f); }
+
+    bool ok() const { return f != NULL; }
+
+    /// Append one node (with its pointers already turned into offsets)
+    void put(const void* node) {
+        if (f && fwrite(node, h.node_size, 1, f) == 1)
+            h.nodes++;
+    }
+
+    /// Write the final header and close the file
+    bool finish() {
+        if (!f)
+            return false;
+        bool ok = !fseek(f, 0, SEEK_SET) && fwrite(&h, sizeof(h), 1, f) == 1;
+        ok = !fclose(f) && ok;
+        f = NULL;
+        return ok;
+    }
+};
+
+/**
+ * Map an image, after checking that it was written for this kind of
+ * structure, node layout, and element count.  Returns the base of the
+ * mapping (nodes start at base + sizeof(ImageHeader)), or NULL.
+ */
+inline char* image_map(const char* path, const char* kind, uint32_t node_size,
+                       uint64_t elements, uint64_t& nodes)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    ImageHeader h;
+    struct stat st;
+    if (read(fd, &h, sizeof(h)) != sizeof(h) || fstat(fd, &st) ||
+        strncmp(h.magic, "tmubimg", sizeof(h.magic)) ||
+        strncmp(h.kind, kind, sizeof(h.kind)) ||
+        h.ptr_size != sizeof(void*) || h.node_size != node_size ||
+        h.elements != elements ||
+        (uint64_t)st.st_size != sizeof(h) + h.nodes * h.node_size)
+    {
+        close(fd);
+        return NULL;
+    }
+    void* base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        return NULL;
+    alloc_foreign(base, st.st_size);
+    nodes = h.nodes;
+    return (char*)base;
+}
+
+/// Undo image_map, for a load that finds the nodes don't hang together
+inline void image_unmap(char* base, uint32_t node_size, uint64_t nodes)
+{
+    alloc_unforeign(base);
+    munmap(base, sizeof(ImageHeader) + nodes * node_size);
+}
+
+/// Sets that support images provide load_image/save_image members; for the
+/// rest, these report that no image was used.  Call with 0 as the last
+/// argument.
+template<class S>
+auto image_load(S* s, const char* path, uint64_t elements, int)
+    -> decltype(s->load_image(path, elements))
+{
+    return s->load_image(path, elements);
+}
+
+template<class S>
+bool image_load(S*, const char*, uint64_t, long) { return false; }
+
+template<class S>
+auto image_save(S* s, const char* path, uint64_t elements, int)
+    -> decltype(s->save_image(path, elements))
+{
+    return s->save_image(path, elements);
+}
+
+template<class S>
+bool image_save(S*, const char*, uint64_t, long) { return false; }
@@ -0,0 +1,101 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <sstream>
+#include <cstdlib>
+#include "alt-license/rand_r_32.h"
+
+/**
+ * Draws keys in [0, n), either uniformly or from a Zipf distribution where
+ * key 0 is the most popular.  The Zipf sampler is the constant-time one from
+ * Gray et al., "Quickly Generating Billion-Record Synthetic Databases"
+ * (also used by YCSB); setup is O(n), to compute zeta(n).  theta must be in
+ * (0, 1).
+ *
+ * Not transaction_safe (it uses pow), so draw keys before starting a
+ * transaction.
+ */
+class KeyDist
+{
+    uint64_t n;
+    bool     zipf;
+    double   theta, zetan, alpha, eta, half_pow;
+
+    static double zeta(uint64_t n, double theta) {
+        double sum = 0;
+        for (uint64_t i = 1; i <= n; ++i)
+            sum += 1.0 / std::pow((double)i, theta);
+        return sum;
+    }
+
+  public:
+
+    /// a uniform distribution over [0, n)
+    KeyDist(uint64_t _n)
+        : n(_n), zipf(false), theta(0), zetan(0), alpha(0), eta(0),
+          half_pow(0)
+    { }
+
+    /// a Zipf distribution over [0, n), with skew theta
+    KeyDist(uint64_t _n, double _theta)
+        : n(_n), zipf(true), theta(_theta), zetan(zeta(_n, _theta)),
+          alpha(1.0 / (1.0 - _theta)),
+          eta((1.0 - std::pow(2.0 / _n, 1.0 - _theta))
+              / (1.0 - zeta(2, _theta) / zetan)),
+          half_pow(1.0 + std::pow(0.5, _theta))
+    { }
+
+    /// parse "uniform", "zipf" (theta 0.99), or "zipf<theta>", e.g. zipf0.8;
+    /// returns NULL if the name isn't one of these
+    static KeyDist* parse(const std::string& name, uint64_t n) {
+        if (name == "uniform")
+            return new KeyDist(n);
+        if (name.compare(0, 4, "zipf") != 0)
+            return NULL;
+        double t = (name.size() > 4) ? atof(name.c_str() + 4) : 0.99;
+        if (t <= 0 || t >= 1)
+            return NULL;
+        return new KeyDist(n, t);
+    }
+
+    /// rand_r_32 gives 31 random bits; a space bigger than that (e.g., a
+    /// forest's trees times keys) gets 62, from two draws
+    uint64_t bits(uint32_t* seed) const {
+        uint64_t r = rand_r_32(seed);
+        return (n > (1u << 31)) ? (r << 31) | rand_r_32(seed) : r;
+    }
+
+    uint64_t next(uint32_t* seed) const {
+        if (!zipf)
+            return bits(seed) % n;
+        double u = bits(seed) / ((n > (1u << 31)) ? 4611686018427387904.0
+                                                  : 2147483648.0);
+        double uz = u * zetan;
+        if (uz < 1.0)
+            return 0;
+        if (uz < half_pow)
+            return 1;
+        uint64_t k = (uint64_t)(n * std::pow(eta * u - eta + 1.0, alpha));
+        return (k < n) ? k : n - 1;
+    }
+
+    std::string name() const {
+        if (!zipf)
+            return "uniform";
+        std::ostringstream s;
+        s << "zipf" << theta;
+        return s.str();
+    }
+};
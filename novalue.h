@@ -0,0 +1,18 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+/**
+ * The value type of a map that the benchmarks use as an IntSet.  It is
+ * empty, and a node holds its value [[no_unique_address]], so a set's nodes
+ * are the size they were before the sets became maps.
+ */
+struct NoValue { };
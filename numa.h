@@ -0,0 +1,241 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// set_mempolicy(2) without libnuma, which we don't want to depend on
+inline long numa_set_mempolicy(int mode, const unsigned long* mask,
+                               unsigned long maxnode)
+{
+    return syscall(SYS_set_mempolicy, mode, mask, maxnode);
+}
+
+/**
+ * Where the memory of the data structure lives on a NUMA machine (-M):
+ *
+ *   none        wherever the thread that first touches it runs (for a
+ *               warmed set, that is the one thread that ran warmup)
+ *   interleave  page by page across all nodes
+ *   owner       each thread warms up its own share of the keys, from the
+ *               node it will run on
+ *   bind<N>     all on node N
+ *
+ * Interleave and bind are memory policies of the main thread, set before the
+ * structure is built, and inherited by every thread it starts, so they cover
+ * everything the benchmark allocates (as numactl would).  With any policy,
+ * threads are pinned to nodes in groups: the first threads/nodes on node 0,
+ * and so on.  On a machine with one node all of this is a no-op.
+ */
+class NumaPlacement
+{
+  public:
+
+    enum Policy { NONE, INTERLEAVE, OWNER, BIND };
+
+  private:
+
+    // from <linux/mempolicy.h>
+    static const int MPOL_INTERLEAVE_ = 3;
+    static const int MPOL_BIND_       = 2;
+
+    Policy                policy;
+    int                   bind_node;
+    std::vector<int>      nodes;        /// online node ids
+    std::vector<uint64_t> start;        /// numastat counters at setup
+
+    NumaPlacement() : policy(NONE), bind_node(0) { }
+
+    /// the numbers in a sysfs list like "0-3,8"
+    static std::vector<int> read_list(const std::string& path) {
+        std::vector<int> out;
+        FILE* f = fopen(path.c_str(), "r");
+        if (!f)
+            return out;
+        int lo, hi;
+        char sep;
+        while (fscanf(f, "%d", &lo) == 1) {
+            hi = lo;
+            if (fscanf(f, "%c", &sep) == 1 && sep == '-') {
+                if (fscanf(f, "%d", &hi) != 1)
+                    break;
+                if (fscanf(f, "%c", &sep) != 1)
+                    sep = '\n';
+            }
+            for (int i = lo; i <= hi; ++i)
+                out.push_back(i);
+            if (sep != ',')
+                break;
+        }
+        fclose(f);
+        return out;
+    }
+
+    static std::string node_dir(int n) {
+        return "/sys/devices/system/node/node" + std::to_string(n) + "/";
+    }
+
+    /// local_node and other_node, summed over all nodes.  These count page
+    /// allocations on the whole machine, not just ours, and not accesses;
+    /// nothing cheaper than uncore counters counts remote accesses.
+    std::vector<uint64_t> numastat() const {
+        std::vector<uint64_t> s(2, 0);
+        for (int n : nodes) {
+            FILE* f = fopen((node_dir(n) + "numastat").c_str(), "r");
+            if (!f)
+                continue;
+            char key[64];
+            unsigned long long v;
+            while (fscanf(f, "%63s %llu", key, &v) == 2) {
+                if (!strcmp(key, "local_node"))
+                    s[0] += v;
+                else if (!strcmp(key, "other_node"))
+                    s[1] += v;
+            }
+            fclose(f);
+        }
+        return s;
+    }
+
+    /// our resident pages on each node, from /proc/self/numa_maps
+    std::vector<uint64_t> pages() const {
+        std::vector<uint64_t> p(nodes.empty() ? 1 : nodes.back() + 1, 0);
+        FILE* f = fopen("/proc/self/numa_maps", "r");
+        if (!f)
+            return p;
+        char tok[256];
+        int n;
+        unsigned long long v;
+        while (fscanf(f, "%255s", tok) == 1)
+            if (sscanf(tok, "N%d=%llu", &n, &v) == 2 && n >= 0 &&
+                n < (int)p.size())
+                p[n] += v;
+        fclose(f);
+        return p;
+    }
+
+  public:
+
+    static NumaPlacement& get() {
+        static NumaPlacement p;
+        return p;
+    }
+
+    /// parse -M; false if it isn't a policy
+    bool parse(const std::string& s) {
+        if (s == "none")            policy = NONE;
+        else if (s == "interleave") policy = INTERLEAVE;
+        else if (s == "owner")      policy = OWNER;
+        else if (s.compare(0, 4, "bind") == 0 && s.size() > 4) {
+            policy = BIND;
+            bind_node = atoi(s.c_str() + 4);
+        }
+        else
+            return false;
+        return true;
+    }
+
+    /// is placement doing anything?
+    bool active() const { return policy != NONE && nodes.size() > 1; }
+
+    /// should each thread warm up its own share of the set?
+    bool owner() const { return active() && policy == OWNER; }
+
+    /// Find the nodes, and set the main thread's memory policy, before any
+    /// of the structure is allocated.  Falls back to none, with a note, if
+    /// there is only one node or the kernel says no.
+    void setup() {
+        if (policy == NONE)
+            return;
+        nodes = read_list("/sys/devices/system/node/online");
+        if (nodes.size() < 2) {
+            std::cout << "numa, nodes=" << nodes.size()
+                      << ", placement is a no-op on a single-node host"
+                      << std::endl;
+            policy = NONE;
+            return;
+        }
+        if (policy == BIND && (bind_node < 0 || bind_node > nodes.back())) {
+            std::cerr << "No NUMA node " << bind_node << "\n";
+            exit(1);
+        }
+        if (policy == INTERLEAVE || policy == BIND) {
+            std::vector<unsigned long> mask(nodes.back() / 64 + 1, 0);
+            if (policy == BIND)
+                mask[bind_node / 64] |= 1ul << (bind_node % 64);
+            else
+                for (int n : nodes)
+                    mask[n / 64] |= 1ul << (n % 64);
+            int mode = (policy == BIND) ? MPOL_BIND_ : MPOL_INTERLEAVE_;
+            if (numa_set_mempolicy(mode, mask.data(), mask.size() * 64 + 1)) {
+                std::cout << "numa, set_mempolicy failed (" << strerror(errno)
+                          << "), placement is a no-op" << std::endl;
+                policy = NONE;
+                return;
+            }
+        }
+        start = numastat();
+    }
+
+    /// the node that thread id of threads runs on
+    int node_of(uint32_t id, uint32_t threads) const {
+        return nodes[(uint64_t)id * nodes.size() / threads];
+    }
+
+    /// pin the calling thread to the CPUs of its node
+    void bind_thread(uint32_t id, uint32_t threads) const {
+        if (!active())
+            return;
+        std::vector<int> cpus =
+            read_list(node_dir(node_of(id, threads)) + "cpulist");
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c : cpus)
+            if (c < CPU_SETSIZE)
+                CPU_SET(c, &set);
+        if (!cpus.empty())
+            sched_setaffinity(0, sizeof(set), &set);
+    }
+
+    /// Report the policy, where our pages ended up, and how the machine's
+    /// page allocations split between local and remote nodes since setup
+    void report() const {
+        if (!active())
+            return;
+        static const char* names[] = { "none", "interleave", "owner", "bind" };
+        std::vector<uint64_t> now = numastat();
+        uint64_t local = now[0] - start[0], remote = now[1] - start[1];
+        std::cout << "numa, policy=" << names[policy];
+        if (policy == BIND)
+            std::cout << bind_node;
+        std::cout << ", nodes=" << nodes.size()
+                  << ", local_allocs=" << local
+                  << ", remote_allocs=" << remote
+                  << ", local%=" << (local + remote ? 100.0 * local
+                                                     / (local + remote) : 0)
+                  << ", pages=";
+        std::vector<uint64_t> p = pages();
+        for (size_t i = 0; i < nodes.size(); ++i)
+            std::cout << (i ? "/" : "") << "N" << nodes[i] << ":"
+                      << p[nodes[i]];
+        std::cout << std::endl;
+    }
+};
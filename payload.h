@@ -0,0 +1,143 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include "image.h"
+#include "verify.h"
+
+extern thread_local int thread_id;
+
+/**
+ * Values for the key/value maps (RBMap, ListMap, HashMap, StdMap), so that
+ * updates can carry records of a given size.  A Payload is N bytes of words;
+ * put() writes the same stamp to every word, so a value read back with
+ * mixed stamps was torn by a concurrent update.
+ */
+template<int N>
+struct Payload
+{
+    static_assert(N % 4 == 0, "payloads are whole words");
+    uint32_t w[N / 4];
+};
+
+/// The payload sizes that the maps are instantiated for, as an X-macro.  A
+/// -V of 4 uses a plain int.
+#define PAYLOAD_SIZES(X) X(8) X(16) X(32) X(64) X(128) X(256) X(512) X(1024)
+
+/// stamp every word of a payload; an int value is just the stamp
+template<int N>
+inline void payload_fill(Payload<N>& v, uint32_t stamp)
+{
+    for (int i = 0; i < N / 4; ++i)
+        v.w[i] = stamp;
+}
+
+inline void payload_fill(int& v, uint32_t stamp) { v = stamp; }
+
+/// true unless the words of a payload have different stamps
+template<int N>
+inline bool payload_ok(const Payload<N>& v)
+{
+    for (int i = 1; i < N / 4; ++i)
+        if (v.w[i] != v.w[0])
+            return false;
+    return true;
+}
+
+inline bool payload_ok(const int&) { return true; }
+
+/// count torn reads from inside a transaction, without instrumentation
+__attribute__((transaction_pure))
+inline void payload_torn(std::atomic<uint64_t>& torn) { torn++; }
+
+/**
+ * The harness speaks IntSet, so this wraps a key/value map to run the usual
+ * lookup/insert/remove mix as get/put/remove with payloads copied in and out
+ * of the transaction.  Puts overwrite, so an insert "miss" in the results is
+ * an update of a key that was already there.
+ */
+template<class MAP, class V>
+class PayloadSet
+{
+    MAP map;
+
+    /// reads that saw a torn value; must stay 0
+    std::atomic<uint64_t> torn;
+
+    bool untorn() const
+    {
+        if (torn)
+            std::cout << "payload, torn reads=" << torn << std::endl;
+        return !torn;
+    }
+
+  public:
+
+    PayloadSet() : torn(0) { }
+
+    bool lookup(int key) const
+    {
+        V v;
+        bool found = map.get(key, v);
+        if (found && !payload_ok(v))
+            payload_torn(const_cast<std::atomic<uint64_t>&>(torn));
+        return found;
+    }
+
+    bool insert(int key)
+    {
+        V v;
+        payload_fill(v, ((uint32_t)thread_id << 24) ^ key);
+        return map.insert_or_assign(key, v);
+    }
+
+    bool remove(int key) { return map.remove(key); }
+
+    bool isSane() const { return untorn() && map.isSane(); }
+
+    bool verify(uint32_t threads, uint32_t sample) const
+    {
+        return untorn() && verify_set(&map, threads, sample, 0);
+    }
+
+    /// -i: images are the map's, if it has them
+    bool save_image(const char* path, uint64_t elements) const
+    {
+        return image_save(&map, path, elements, 0);
+    }
+
+    bool load_image(const char* path, uint64_t elements)
+    {
+        return image_load(&map, path, elements, 0);
+    }
+};
+
+/// Call f.run<V>() with V the value type for a -V of bytes; false if there
+/// is no such payload size
+template<class F>
+bool with_payload(uint32_t bytes, F f)
+{
+    if (bytes == 4) {
+        f.template run<int>();
+        return true;
+    }
+#define PAYLOAD_CASE(N)                                 \
+    if (bytes == N) {                                   \
+        f.template run<Payload<N> >();                  \
+        return true;                                    \
+    }
+    PAYLOAD_SIZES(PAYLOAD_CASE)
+#undef PAYLOAD_CASE
+    return false;
+}
@@ -0,0 +1,311 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include "timing.h"
+
+extern thread_local int thread_id;
+
+/**
+ * Safe deferred freeing for data structures that don't use TM, and so can't
+ * just free() a node that a concurrent reader might still be looking at.
+ * There are two reclaimers with the same interface, so a data structure (or
+ * ReclaimBench) can be written once against either:
+ *
+ *   enter()/exit()      bracket each operation
+ *   protect(slot, src)  read a shared pointer, keeping its target alive
+ *                       until exit()
+ *   retire(p, bytes)    p is unlinked; free it once no one can see it
+ *   stats()             totals across threads (call when quiescent)
+ *
+ * Threads are identified by the harness's thread_id.  Retired nodes must
+ * have come from malloc().
+ */
+
+/// the most threads the reclaimers support
+static const int RECLAIM_MAX_THREADS = 256;
+
+/// A retired node, and when it was retired
+struct Retired
+{
+    void*    p;
+    uint32_t bytes;
+    uint64_t when;
+};
+
+/// Reclamation counters.  Latencies are from retire() to free(), in ns.
+struct ReclaimStats
+{
+    uint64_t retired;
+    uint64_t freed;
+    uint64_t bytes_retired;
+    uint64_t bytes_freed;
+    uint64_t peak_deferred;     /// most bytes one thread had waiting
+    uint64_t latency_sum;
+    uint64_t latency_max;
+
+    ReclaimStats()
+        : retired(0), freed(0), bytes_retired(0), bytes_freed(0),
+          peak_deferred(0), latency_sum(0), latency_max(0)
+    { }
+
+    void on_retire(uint32_t bytes) {
+        retired++;
+        bytes_retired += bytes;
+        if (bytes_retired - bytes_freed > peak_deferred)
+            peak_deferred = bytes_retired - bytes_freed;
+    }
+
+    void on_free(const Retired& r, uint64_t now) {
+        free(r.p);
+        freed++;
+        bytes_freed += r.bytes;
+        latency_sum += now - r.when;
+        if (now - r.when > latency_max)
+            latency_max = now - r.when;
+    }
+
+    void add(const ReclaimStats& s) {
+        retired       += s.retired;
+        freed         += s.freed;
+        bytes_retired += s.bytes_retired;
+        bytes_freed   += s.bytes_freed;
+        peak_deferred  = std::max(peak_deferred, s.peak_deferred);
+        latency_sum   += s.latency_sum;
+        latency_max    = std::max(latency_max, s.latency_max);
+    }
+};
+
+/**
+ * Epoch-based reclamation.  Each thread has a limbo list per epoch, and
+ * files a retired node under the global epoch as read after the node was
+ * unlinked (a thread's own epoch may be one behind).  The global epoch only
+ * advances once every thread inside an operation has seen the current one,
+ * so once it has moved two past a node's epoch, every operation that could
+ * have reached the node is over, and the node is freed.
+ * Cheap for readers (protect() is a plain load), but one stalled thread
+ * stops all reclamation.
+ */
+class epoch_reclaimer
+{
+    /// how many retires between attempts to advance the epoch
+    static const int ADVANCE_EVERY = 64;
+
+    /// per-thread state, on its own lines
+    struct Record
+    {
+        std::atomic<uint64_t> epoch;    /// epoch this thread last saw
+        std::atomic<bool>     active;   /// inside an operation?
+        std::vector<Retired>  limbo[3]; /// filed under epoch e, at [e % 3]
+        ReclaimStats          stats;
+        char                  padding[64];
+        Record() : epoch(0), active(false) { }
+    };
+
+    std::atomic<uint64_t> global;
+    char                  padding[64 - sizeof(uint64_t)];
+    Record                records[RECLAIM_MAX_THREADS];
+
+    /// free everything in a limbo list
+    static void drain(std::vector<Retired>& bag, ReclaimStats& stats) {
+        if (bag.empty())
+            return;
+        uint64_t now = getElapsedTime();
+        for (const Retired& r : bag)
+            stats.on_free(r, now);
+        bag.clear();
+    }
+
+    /// advance the global epoch if every active thread has seen it
+    void try_advance() {
+        uint64_t e = global.load();
+        for (int i = 0; i < RECLAIM_MAX_THREADS; ++i)
+            if (records[i].active.load() && records[i].epoch.load() != e)
+                return;
+        global.compare_exchange_strong(e, e + 1);
+    }
+
+  public:
+
+    epoch_reclaimer() : global(0) { }
+
+    /// free whatever is still in limbo; no thread may be inside an operation
+    ~epoch_reclaimer() {
+        for (int i = 0; i < RECLAIM_MAX_THREADS; ++i)
+            for (int b = 0; b < 3; ++b)
+                drain(records[i].limbo[b], records[i].stats);
+    }
+
+    /// start an operation
+    void enter() {
+        Record& r = records[thread_id];
+        r.active.store(true);
+        uint64_t e = global.load();
+        uint64_t last = r.epoch.load(std::memory_order_relaxed);
+        // in epoch e, what was filed under e - 2 is unreachable; we filed
+        // under last or last + 1 at most, so if epochs went by while we
+        // were out, the list for e - 3 is done with too
+        if (last != e) {
+            drain(r.limbo[(e + 1) % 3], r.stats);
+            if (e - last >= 2)
+                drain(r.limbo[e % 3], r.stats);
+            r.epoch.store(e);
+        }
+    }
+
+    /// finish an operation
+    void exit() {
+        records[thread_id].active.store(false, std::memory_order_release);
+    }
+
+    /// inside an operation, everything reachable stays reachable
+    template<class T>
+    T* protect(int, const std::atomic<T*>& src) { return src.load(); }
+
+    /// hand over an unlinked node, to be freed once no one can see it
+    void retire(void* p, uint32_t bytes) {
+        Record& r = records[thread_id];
+        r.limbo[global.load() % 3]
+            .push_back(Retired{p, bytes, getElapsedTime()});
+        r.stats.on_retire(bytes);
+        if (r.stats.retired % ADVANCE_EVERY == 0)
+            try_advance();
+    }
+
+    ReclaimStats stats() const {
+        ReclaimStats s;
+        for (int i = 0; i < RECLAIM_MAX_THREADS; ++i)
+            s.add(records[i].stats);
+        return s;
+    }
+};
+
+/**
+ * Hazard pointers (Michael).  Before dereferencing a shared pointer, a
+ * thread publishes it in one of its HAZARDS slots and re-reads the source to
+ * make sure it was still linked.  Retired nodes are freed in batches, once
+ * a scan of every thread's slots shows no one has them published.  Readers
+ * pay a store and fence per node, but a stalled thread only pins the few
+ * nodes it has published.
+ */
+class hazard_reclaimer
+{
+    /// hazard slots per thread
+    static const int HAZARDS = 3;
+
+    /// per-thread state, on its own lines
+    struct Record
+    {
+        std::atomic<void*>   hazard[HAZARDS];
+        bool                 seen;      /// counted in hwm yet?
+        std::vector<Retired> retired;
+        ReclaimStats         stats;
+        char                 padding[64];
+        Record() : seen(false) {
+            for (int i = 0; i < HAZARDS; ++i)
+                hazard[i].store(NULL, std::memory_order_relaxed);
+        }
+    };
+
+    /// one more than the largest thread_id that has used us
+    std::atomic<int> hwm;
+    char             padding[64 - sizeof(int)];
+    Record           records[RECLAIM_MAX_THREADS];
+
+    /// free every retired node of r that no thread has published
+    void scan(Record& r) {
+        std::vector<void*> published;
+        int n = hwm.load();
+        for (int i = 0; i < n; ++i)
+            for (int h = 0; h < HAZARDS; ++h)
+                if (void* p = records[i].hazard[h].load())
+                    published.push_back(p);
+        std::sort(published.begin(), published.end());
+
+        uint64_t now = getElapsedTime();
+        size_t keep = 0;
+        for (size_t i = 0; i < r.retired.size(); ++i) {
+            if (std::binary_search(published.begin(), published.end(),
+                                   r.retired[i].p))
+                r.retired[keep++] = r.retired[i];
+            else
+                r.stats.on_free(r.retired[i], now);
+        }
+        r.retired.resize(keep);
+    }
+
+  public:
+
+    hazard_reclaimer() : hwm(0) { }
+
+    /// free whatever is still retired; no thread may be inside an operation
+    ~hazard_reclaimer() {
+        for (int i = 0; i < RECLAIM_MAX_THREADS; ++i) {
+            uint64_t now = getElapsedTime();
+            for (const Retired& r : records[i].retired)
+                records[i].stats.on_free(r, now);
+        }
+    }
+
+    /// start an operation; the first one makes this thread's slots visible
+    void enter() {
+        Record& r = records[thread_id];
+        if (!r.seen) {
+            r.seen = true;
+            int h = hwm.load();
+            while (h <= thread_id && !hwm.compare_exchange_weak(h, thread_id + 1))
+                ;
+        }
+    }
+
+    /// finish an operation: nothing is published anymore
+    void exit() {
+        Record& r = records[thread_id];
+        for (int i = 0; i < HAZARDS; ++i)
+            r.hazard[i].store(NULL, std::memory_order_release);
+    }
+
+    /// publish what src points to in slot, until it stops changing
+    template<class T>
+    T* protect(int slot, const std::atomic<T*>& src) {
+        std::atomic<void*>& h = records[thread_id].hazard[slot];
+        T* p = src.load();
+        while (true) {
+            h.store(p);
+            T* q = src.load();
+            if (q == p)
+                return p;
+            p = q;
+        }
+    }
+
+    /// hand over an unlinked node; scan once there are enough of them that
+    /// most of each batch will be freeable
+    void retire(void* p, uint32_t bytes) {
+        Record& r = records[thread_id];
+        r.retired.push_back(Retired{p, bytes, getElapsedTime()});
+        r.stats.on_retire(bytes);
+        if (r.retired.size() >= (size_t)std::max(64, 2 * HAZARDS * hwm.load()))
+            scan(r);
+    }
+
+    ReclaimStats stats() const {
+        ReclaimStats s;
+        for (int i = 0; i < RECLAIM_MAX_THREADS; ++i)
+            s.add(records[i].stats);
+        return s;
+    }
+};
@@ -0,0 +1,91 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <string>
+
+/**
+ * The results store: an append-only text file of records, one per run, each
+ * a line of the form
+ *
+ *   result, bench=TreeBench, B=RBTree64K, R=34, ..., throughput=1234567
+ *
+ * Records whose RESULT_KEYS fields all agree describe the same
+ * configuration, and count as trials of it; the rest of the fields are
+ * measurements (txns, time, throughput) and context (when, host, compiler).
+ * The keys are every flag that changes what is measured.  Boolean flags are
+ * 0 or 1, -v is 1 for full, 0 for skip and N for sample<N>, and i is
+ * whether -i was given, since a loaded image lays the set out differently;
+ * a is the -a limit, auto, or off.  Left out: -K, whose passes run before
+ * the timed run, and -o.
+ */
+#define RESULT_KEYS(K)                                                  \
+    K(bench) K(B) K(R) K(d) K(X) K(p) K(m) K(S) K(O) K(E) K(V) K(N)     \
+    K(P) K(H) K(M) K(Q) K(D) K(v) K(l) K(A) K(G) K(i) K(a)
+
+struct ResultRecord
+{
+    std::map<std::string, std::string> fields;
+
+    /// parse a record line; false if it isn't one
+    bool parse(const std::string& line) {
+        if (line.compare(0, 7, "result,") != 0)
+            return false;
+        fields.clear();
+        std::istringstream in(line.substr(7));
+        std::string kv;
+        while (std::getline(in, kv, ',')) {
+            size_t b = kv.find_first_not_of(' '), eq = kv.find('=');
+            if (b == std::string::npos || eq == std::string::npos || eq < b)
+                continue;
+            fields[kv.substr(b, eq - b)] = kv.substr(eq + 1);
+        }
+        return true;
+    }
+
+    /// the configuration, as a string of its RESULT_KEYS fields
+    std::string key() const {
+        std::string k;
+#define RESULT_KEY(F)                                                   \
+        {                                                               \
+            auto i = fields.find(#F);                                   \
+            if (i != fields.end())                                      \
+                k += (k.empty() ? "" : " ") + std::string(#F "=") + i->second; \
+        }
+        RESULT_KEYS(RESULT_KEY)
+#undef RESULT_KEY
+        return k;
+    }
+
+    /// a numeric field, or 0
+    double num(const std::string& f) const {
+        auto i = fields.find(f);
+        return (i == fields.end()) ? 0 : atof(i->second.c_str());
+    }
+};
+
+/// Append one record line to the store at path.  O_APPEND and a single
+/// write keep concurrent runs from interleaving their records.
+inline bool result_append(const std::string& path, const std::string& line)
+{
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0)
+        return false;
+    std::string l = line + "\n";
+    bool ok = write(fd, l.data(), l.size()) == (ssize_t)l.size();
+    close(fd);
+    return ok;
+}
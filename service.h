@@ -0,0 +1,388 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+#include <signal.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+#include "alt-license/rand_r_32.h"
+#include "timing.h"
+#include "alloc.h"
+#include "bmconfig.h"
+#include "combining.h"
+#include "numa.h"
+
+extern thread_local int thread_id;
+
+/// A request handed from a producer to a worker
+struct ServiceRequest
+{
+    int      op;
+    int      val;
+    uint64_t enqueued;                  /// time of enqueue, in ns
+};
+
+/**
+ * A bounded single-producer single-consumer ring.  Capacity is rounded up to
+ * a power of two.  head and tail live on their own lines.
+ */
+template<class T>
+class spsc_ring
+{
+    std::atomic<uint64_t> head;         /// next slot to pop
+    char pad0[64 - sizeof(uint64_t)];
+    std::atomic<uint64_t> tail;         /// next slot to push
+    char pad1[64 - sizeof(uint64_t)];
+    T*       cells;
+    uint64_t mask;
+
+  public:
+
+    spsc_ring(uint32_t capacity) : head(0), tail(0) {
+        uint64_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        cells = new T[size];
+        mask = size - 1;
+    }
+
+    ~spsc_ring() { delete[] cells; }
+
+    /// Push, or return false if full.  depth gets the occupancy we saw.
+    bool push(const T& t, uint64_t& depth) {
+        uint64_t tl = tail.load(std::memory_order_relaxed);
+        depth = tl - head.load(std::memory_order_acquire);
+        if (depth > mask)
+            return false;
+        cells[tl & mask] = t;
+        tail.store(tl + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Pop, or return false if empty
+    bool pop(T& t) {
+        uint64_t hd = head.load(std::memory_order_relaxed);
+        if (hd == tail.load(std::memory_order_acquire))
+            return false;
+        t = cells[hd & mask];
+        head.store(hd + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+/**
+ * A bounded multi-producer multi-consumer ring, after Vyukov: every cell
+ * carries a sequence number that tells producers and consumers whose turn it
+ * is, so the only shared writes are the CASes on the two positions.
+ */
+template<class T>
+class mpmc_ring
+{
+    struct Cell
+    {
+        std::atomic<uint64_t> seq;
+        T                     data;
+    };
+
+    Cell*    cells;
+    uint64_t mask;
+    char pad0[64];
+    std::atomic<uint64_t> enq;
+    char pad1[64 - sizeof(uint64_t)];
+    std::atomic<uint64_t> deq;
+    char pad2[64 - sizeof(uint64_t)];
+
+  public:
+
+    mpmc_ring(uint32_t capacity) : enq(0), deq(0) {
+        uint64_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        cells = new Cell[size];
+        mask = size - 1;
+        for (uint64_t i = 0; i < size; ++i)
+            cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    ~mpmc_ring() { delete[] cells; }
+
+    /// Push, or return false if full.  depth gets the occupancy we saw.
+    bool push(const T& t, uint64_t& depth) {
+        uint64_t pos = enq.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& c = cells[pos & mask];
+            uint64_t seq = c.seq.load(std::memory_order_acquire);
+            int64_t dif = (int64_t)seq - (int64_t)pos;
+            if (dif == 0) {
+                if (enq.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed))
+                {
+                    depth = pos - deq.load(std::memory_order_relaxed);
+                    c.data = t;
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (dif < 0) {
+                depth = mask + 1;
+                return false;
+            }
+            else {
+                pos = enq.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Pop, or return false if empty
+    bool pop(T& t) {
+        uint64_t pos = deq.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& c = cells[pos & mask];
+            uint64_t seq = c.seq.load(std::memory_order_acquire);
+            int64_t dif = (int64_t)seq - (int64_t)(pos + 1);
+            if (dif == 0) {
+                if (deq.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed))
+                {
+                    t = c.data;
+                    c.seq.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (dif < 0) {
+                return false;
+            }
+            else {
+                pos = deq.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+/**
+ * Service mode: instead of every thread generating and running its own
+ * operations, -P producer threads generate requests into bounded rings and
+ * the -p worker threads pull them out and run them as transactions.  With
+ * spsc queues every producer/worker pair gets its own ring; with mpmc there
+ * is a single shared ring.  We report end-to-end latency (enqueue to
+ * commit) and the queue depth producers observed.
+ */
+template<class SET>
+class service
+{
+    typedef spsc_ring<ServiceRequest> SPSC;
+    typedef mpmc_ring<ServiceRequest> MPMC;
+
+    /// log2 buckets for latency, in ns
+    static const int BUCKETS = 64;
+
+    /// What a producer saw
+    struct ProducerStats
+    {
+        uint64_t pushed;
+        uint64_t depth_sum;
+        uint64_t depth_max;
+        uint64_t full_stalls;
+        ProducerStats() : pushed(0), depth_sum(0), depth_max(0),
+                          full_stalls(0) { }
+    };
+
+    /// What a worker saw
+    struct WorkerStats
+    {
+        ThreadStats ts;
+        uint64_t    lat_sum;
+        uint64_t    hist[BUCKETS];
+        WorkerStats() : ts(), lat_sum(0), hist() { }
+    };
+
+    SET*     set;
+    uint32_t producers;
+    uint32_t workers;
+    bool     shared;                    /// one mpmc ring, or a spsc mesh
+
+    std::vector<SPSC*> mesh;            /// mesh[p * workers + w]
+    MPMC*              ring;
+
+    std::atomic<uint32_t> producers_done;
+
+    std::vector<ProducerStats> pstats;
+    std::vector<WorkerStats>   wstats;
+
+    /// Generate requests until time is up (or -X requests are made)
+    void produce(uint32_t p) {
+        ProducerStats& ps = pstats[p];
+        uint32_t seed = p;
+        uint32_t next = 0;
+        for (uint32_t e = 0; Config::CFG.execute ? e < Config::CFG.execute
+                                                 : Config::CFG.running.load(); ++e)
+        {
+            ServiceRequest r;
+            r.val = rand_r_32(&seed) % Config::CFG.elements;
+            uint32_t act = rand_r_32(&seed) % 100;
+            r.op = act < Config::CFG.lookpct ? OP_LOOKUP
+                : act < Config::CFG.inspct ? OP_INSERT : OP_REMOVE;
+            r.enqueued = getElapsedTime();
+            uint64_t depth;
+            while (true) {
+                // spsc producers try their workers round-robin
+                bool ok = shared ? ring->push(r, depth)
+                    : mesh[p * workers + next]->push(r, depth);
+                if (!shared)
+                    next = (next + 1) % workers;
+                if (ok)
+                    break;
+                ++ps.full_stalls;
+            }
+            ++ps.pushed;
+            ps.depth_sum += depth;
+            if (depth > ps.depth_max)
+                ps.depth_max = depth;
+        }
+        producers_done.fetch_add(1, std::memory_order_release);
+    }
+
+    /// Get a request for worker w, or return false if there is none
+    bool take(uint32_t w, ServiceRequest& r) {
+        if (shared)
+            return ring->pop(r);
+        for (uint32_t p = 0; p < producers; ++p)
+            if (mesh[p * workers + w]->pop(r))
+                return true;
+        return false;
+    }
+
+    /// Run requests until the producers are done and the queues are drained
+    void work(uint32_t w) {
+        thread_id = w;
+        if (Config::CFG.alloc_stats)
+            alloc_bind_thread(w);
+        NumaPlacement::get().bind_thread(w, workers);
+        init_thread(set, w, 0);
+        WorkerStats& ws = wstats[w];
+        uint64_t last = getElapsedTime();
+        while (true) {
+            ServiceRequest r;
+            if (!take(w, r)) {
+                if (producers_done.load(std::memory_order_acquire) < producers)
+                    continue;
+                // everyone is done; one more pass to drain what's left
+                if (!take(w, r))
+                    break;
+            }
+            bool res = run_op(set, r.op, r.val);
+            uint64_t now = getElapsedTime();
+            uint64_t lat = now - r.enqueued;
+            if (now - last > ws.ts.max_gap)
+                ws.ts.max_gap = now - last;
+            last = now;
+            ws.ts.counts[2 * r.op + (res ? 0 : 1)]++;
+            ws.ts.ops++;
+            ws.lat_sum += lat;
+            if (ws.ts.min_latency == 0 || lat < ws.ts.min_latency)
+                ws.ts.min_latency = lat;
+            if (lat > ws.ts.max_latency)
+                ws.ts.max_latency = lat;
+            int b = 0;
+            while (b < BUCKETS - 1 && (lat >> (b + 1)))
+                ++b;
+            ws.hist[b]++;
+        }
+    }
+
+    /// Approximate percentile, as the upper bound of its log2 bucket
+    uint64_t percentile(const uint64_t* hist, uint64_t total, double pct) {
+        uint64_t target = total * pct, seen = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            seen += hist[b];
+            if (seen > target)
+                return (b < BUCKETS - 1) ? (2ULL << b) : UINT64_MAX;
+        }
+        return 0;
+    }
+
+  public:
+
+    service(SET* _set)
+        : set(_set), producers(Config::CFG.producers),
+          workers(Config::CFG.threads), shared(Config::CFG.queue == "mpmc"),
+          ring(NULL), producers_done(0), pstats(producers), wstats(workers)
+    {
+        if (shared)
+            ring = new MPMC(Config::CFG.queue_depth);
+        else
+            for (uint32_t i = 0; i < producers * workers; ++i)
+                mesh.push_back(new SPSC(Config::CFG.queue_depth));
+    }
+
+    ~service() {
+        delete ring;
+        for (auto q : mesh)
+            delete q;
+    }
+
+    /// Launch producers and workers, wait for them, and fill in the totals
+    void launch() {
+        if (!Config::CFG.execute) {
+            signal(SIGALRM, Config::catch_SIGALRM);
+            alarm(Config::CFG.duration);
+        }
+        uint64_t start = getElapsedTime();
+        std::vector<std::thread> threads;
+        for (uint32_t w = 0; w < workers; ++w)
+            threads.push_back(std::thread(&service::work, this, w));
+        for (uint32_t p = 0; p < producers; ++p)
+            threads.push_back(std::thread(&service::produce, this, p));
+        for (auto& t : threads)
+            t.join();
+        Config::CFG.time = getElapsedTime() - start;
+
+        // fold the workers into the usual totals
+        Config::CFG.thread_stats.clear();
+        uint64_t hist[BUCKETS] = {0}, total = 0, lat_sum = 0;
+        for (auto& ws : wstats) {
+            Config::CFG.txcount     += ws.ts.ops;
+            Config::CFG.lookup_hit  += ws.ts.counts[0];
+            Config::CFG.lookup_miss += ws.ts.counts[1];
+            Config::CFG.insert_hit  += ws.ts.counts[2];
+            Config::CFG.insert_miss += ws.ts.counts[3];
+            Config::CFG.remove_hit  += ws.ts.counts[4];
+            Config::CFG.remove_miss += ws.ts.counts[5];
+            Config::CFG.thread_stats.push_back(ws.ts);
+            for (int b = 0; b < BUCKETS; ++b)
+                hist[b] += ws.hist[b];
+            total   += ws.ts.ops;
+            lat_sum += ws.lat_sum;
+        }
+        uint64_t pushed = 0, depth_sum = 0, depth_max = 0, stalls = 0;
+        for (auto& ps : pstats) {
+            pushed    += ps.pushed;
+            depth_sum += ps.depth_sum;
+            depth_max  = std::max(depth_max, ps.depth_max);
+            stalls    += ps.full_stalls;
+        }
+
+        std::cout << "service, producers=" << producers
+                  << ", workers=" << workers
+                  << ", queue=" << (shared ? "mpmc" : "spsc")
+                  << ", depth=" << Config::CFG.queue_depth
+                  << ", lat_avg=" << (total ? lat_sum / total : 0)
+                  << ", lat_p50=" << percentile(hist, total, 0.50)
+                  << ", lat_p99=" << percentile(hist, total, 0.99)
+                  << ", lat_p999=" << percentile(hist, total, 0.999)
+                  << ", qdepth_avg=" << (pushed ? (double)depth_sum / pushed : 0)
+                  << ", qdepth_max=" << depth_max
+                  << ", full_stalls=" << stalls << std::endl;
+    }
+};
@@ -0,0 +1,194 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "alt-license/rand_r_32.h"
+
+/**
+ * A variable-length string key.  The bytes live in a StrArena, but the first
+ * eight are also kept inline, big-endian and zero-padded, so that comparing
+ * the prefixes as integers orders keys the way memcmp would.  Most
+ * comparisons end there; only keys that share their first eight bytes chase
+ * the pointer.  Keys may not contain NUL bytes.
+ */
+struct StrKey
+{
+    uint64_t    prefix;     /// the first eight bytes, as a big-endian number
+    const char* bytes;      /// the whole key
+    uint32_t    len;
+
+    StrKey() : prefix(0), bytes(NULL), len(0) { }
+
+    /// the key of len bytes at s, which must outlive the key
+    StrKey(const char* s, uint32_t _len) : prefix(0), bytes(s), len(_len) {
+        for (uint32_t i = 0; i < 8; ++i)
+            prefix = (prefix << 8) | (i < len ? (uint8_t)s[i] : 0);
+    }
+
+    /// memcmp-style comparison of the bytes after the prefix.  Keys are
+    /// never written once made, so the bytes don't need to be read
+    /// transactionally; the pointers and lengths do, and are passed in.
+    __attribute__((transaction_pure))
+    static int compare_tail(const char* a, uint32_t alen,
+                            const char* b, uint32_t blen)
+    {
+        uint32_t n = alen < blen ? alen : blen;
+        for (uint32_t i = 8; i < n; ++i)
+            if (a[i] != b[i])
+                return (uint8_t)a[i] < (uint8_t)b[i] ? -1 : 1;
+        return (alen < blen) ? -1 : (alen > blen);
+    }
+
+    bool operator<(const StrKey& o) const {
+        uint64_t p = prefix, op = o.prefix;
+        if (p != op)
+            return p < op;
+        return compare_tail(bytes, len, o.bytes, o.len) < 0;
+    }
+
+    bool operator==(const StrKey& o) const {
+        uint32_t l = len;
+        if (prefix != o.prefix || l != o.len)
+            return false;
+        return (l <= 8) || compare_tail(bytes, l, o.bytes, l) == 0;
+    }
+};
+
+/**
+ * Bump allocator for key bytes.  Each thread that makes keys has its own,
+ * so keys are packed together, near the thread that made them, with no
+ * per-key malloc header.  Nothing is freed until the arena is.
+ */
+class StrArena
+{
+    static const size_t CHUNK = 1 << 20;
+
+    std::vector<char*> chunks;
+    char*              next;
+    size_t             left;
+
+  public:
+
+    uint64_t bytes;     /// bytes handed out
+
+    StrArena() : next(NULL), left(0), bytes(0) { }
+
+    ~StrArena() {
+        for (char* c : chunks)
+            free(c);
+    }
+
+    char* alloc(size_t n) {
+        if (n > left) {
+            left = n > CHUNK ? n : CHUNK;
+            next = (char*)malloc(left);
+            chunks.push_back(next);
+        }
+        char* p = next;
+        next += n;
+        left -= n;
+        bytes += n;
+        return p;
+    }
+};
+
+/**
+ * Makes the i-th key of a key space, deterministically, with lengths drawn
+ * from one of a few distributions:
+ *
+ *   short     8-16 bytes, uniform (identifiers, hashes)
+ *   mixed     75% 8-24 bytes, 25% 100-250 bytes (names and descriptions)
+ *   url       a shared 24-byte "https://www.example.com/" and a lognormal
+ *             length, median ~60 and at most 200 bytes; the shared prefix
+ *             defeats the inline prefix, so every comparison chases
+ *   fixed<N>  exactly N bytes, N >= 8
+ *
+ * Every key contains a 7-character code that is unique to i, right after
+ * the shared prefix (if any), followed by random filler.
+ */
+class StrKeyGen
+{
+    enum Kind { SHORT, MIXED, URL, FIXED };
+
+    Kind        kind;
+    uint32_t    fixed;
+    std::string name_;
+
+    static const char* url_prefix() { return "https://www.example.com/"; }
+
+    StrKeyGen(Kind k, uint32_t f, const std::string& n)
+        : kind(k), fixed(f), name_(n)
+    { }
+
+    /// a length in [lo, hi], with Box-Muller for the lognormal
+    uint32_t length(uint32_t* seed) const {
+        switch (kind) {
+          case SHORT:
+            return 8 + rand_r_32(seed) % 9;
+          case MIXED:
+            if (rand_r_32(seed) % 4)
+                return 8 + rand_r_32(seed) % 17;
+            return 100 + rand_r_32(seed) % 151;
+          case URL: {
+            double u1 = (rand_r_32(seed) + 1.0) / 2147483649.0;
+            double u2 = rand_r_32(seed) / 2147483648.0;
+            double z = std::sqrt(-2 * std::log(u1)) * std::cos(2 * M_PI * u2);
+            double l = std::exp(std::log(60.0) + 0.5 * z);
+            return l < 31 ? 31 : (l > 200 ? 200 : (uint32_t)l);
+          }
+          default:
+            return fixed;
+        }
+    }
+
+  public:
+
+    /// parse a distribution name; NULL if it isn't one
+    static StrKeyGen* parse(const std::string& name) {
+        if (name == "short") return new StrKeyGen(SHORT, 0, name);
+        if (name == "mixed") return new StrKeyGen(MIXED, 0, name);
+        if (name == "url")   return new StrKeyGen(URL, 0, name);
+        if (name.compare(0, 5, "fixed") == 0) {
+            int n = atoi(name.c_str() + 5);
+            if (n >= 8)
+                return new StrKeyGen(FIXED, n, name);
+        }
+        return NULL;
+    }
+
+    const std::string& name() const { return name_; }
+
+    /// make key i, with its bytes in arena
+    StrKey make(uint32_t i, StrArena& arena) const {
+        static const char code_chars[] = "0123456789abcdefghijklmnopqrstuv";
+        static const char fill_chars[] = "abcdefghijklmnopqrstuvwxyz0123456789-_/.";
+        uint32_t seed = i * 2654435761u + 1;
+        uint32_t len = length(&seed);
+        char* s = arena.alloc(len);
+        uint32_t pos = 0;
+        if (kind == URL)
+            for (const char* p = url_prefix(); *p; ++p)
+                s[pos++] = *p;
+        // 7 base-32 digits of a bijection of i, so keys are unique but not
+        // in index order
+        uint64_t code = (uint32_t)(i * 2654435761u);
+        for (int d = 6; d >= 0; --d)
+            s[pos++] = code_chars[(code >> (5 * d)) & 31];
+        while (pos < len)
+            s[pos++] = fill_chars[rand_r_32(&seed) % (sizeof(fill_chars) - 1)];
+        return StrKey(s, len);
+    }
+};
@@ -0,0 +1,68 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "timing.h"
+
+/**
+ * Post-run verification.  A SET that can check itself in pieces provides
+ * verify(threads, sample), which splits the check into units, runs them on
+ * up to threads threads, and with a sample of N > 1 checks only about 1/N
+ * of the units.  Everything else just gets isSane().  Call with 0 as the
+ * last argument.
+ */
+template<class SET>
+auto verify_set(SET* set, uint32_t threads, uint32_t sample, int)
+    -> decltype(set->verify(threads, sample))
+{
+    return set->verify(threads, sample);
+}
+
+template<class SET>
+bool verify_set(SET* set, uint32_t, uint32_t, long)
+{
+    return set->isSane();
+}
+
+/// is unit u in this run's 1/sample of the units?  The choice changes from
+/// run to run, so that a sweep covers every unit eventually
+inline bool verify_sampled(uint32_t u, uint32_t sample)
+{
+    static const uint32_t salt = (uint32_t)getElapsedTime();
+    return sample <= 1 || ((u * 2654435761u + salt) >> 8) % sample == 0;
+}
+
+/// run check(u) for every unit u in [0, units) that the sample includes,
+/// on up to threads threads; true iff every check passed
+template<class F>
+bool verify_units(uint32_t units, uint32_t threads, uint32_t sample, F check)
+{
+    std::atomic<uint32_t> next(0);
+    std::atomic<bool>     ok(true);
+    auto worker = [&]() {
+        for (uint32_t u = next++; u < units && ok; u = next++)
+            if (verify_sampled(u, sample) && !check(u))
+                ok = false;
+    };
+    if (threads > units)
+        threads = units;
+    std::vector<std::thread> helpers;
+    for (uint32_t t = 1; t < threads; ++t)
+        helpers.push_back(std::thread(worker));
+    worker();
+    for (std::thread& h : helpers)
+        h.join();
+    return ok;
+}
@@ -0,0 +1,71 @@
+// -*-c++-*-
+//
+//  Copyright (C) 2011, 2014
+//  University of Rochester Department of Computer Science
+//    and
+//  Lehigh University Department of Computer Science and Engineering
+//
+// License: Modified BSD
+//          Please see the file LICENSE for licensing information
+
+#pragma once
+
+#include <cstdint>
+#include "alt-license/rand_r_32.h"
+
+/// Keys drawn uniformly from [0, n), for any n
+struct ModKeys
+{
+    static const char* name() { return "mod"; }
+    static uint32_t range(uint32_t elements) { return elements; }
+    static uint32_t next(uint32_t* seed, uint32_t n) {
+        return rand_r_32(seed) % n;
+    }
+};
+
+/// Keys drawn uniformly from [0, n), for n a power of 2: a mask, not a divide
+struct Pow2Keys
+{
+    static const char* name() { return "pow2"; }
+    static uint32_t range(uint32_t elements) { return elements - 1; }
+    static uint32_t next(uint32_t* seed, uint32_t mask) {
+        return rand_r_32(seed) & mask;
+    }
+};
+
+/**
+ * A workload with everything about it fixed at compile time: lookups are
+ * LOOK% of the operations, inserts the next (INS - LOOK)%, and removes the
+ * rest (so LOOK and INS mean what lookpct and inspct do in Config), there
+ * are NOPS no-ops of think time after each transaction, and KEYS picks the
+ * keys.  The harness compiles a loop for each of these, with the mix
+ * branches folded away and nothing read through Config::CFG per iteration.
+ */
+template<uint32_t LOOK, uint32_t INS, uint32_t NOPS, class KEYS>
+struct Workload
+{
+    static const uint32_t lookpct = LOOK;
+    static const uint32_t inspct  = INS;
+    static const uint32_t nops    = NOPS;
+    typedef KEYS keys;
+
+    static void think() {
+        for (uint32_t i = 0; i < NOPS; i++)
+            __asm__ __volatile__("nop");
+    }
+};
+
+/// The workloads that get their own loop, as an X-macro of (LOOK, INS,
+/// NOPS), each of them with both key generators: the default mix, the
+/// mixes that -R 0, 50, 80, 90, 100 and 34 give, and the default mix with
+/// some think time.  Anything else runs the generic loop.
+#define WORKLOADS(X)                                                    \
+    X(34, 66, 0)                                                        \
+    X(34, 67, 0)                                                        \
+    X(0, 50, 0)                                                         \
+    X(50, 75, 0)                                                        \
+    X(80, 90, 0)                                                        \
+    X(90, 95, 0)                                                        \
+    X(100, 100, 0)                                                      \
+    X(34, 66, 100)                                                      \
+    X(34, 66, 1000)